@@ -0,0 +1,176 @@
+//=================================================================================
+// Name        : Align.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Offset estimation between two clips by FFT cross-correlation with
+// 				 a decimated coarse search and a full-rate fine search
+//=================================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "FFT.h"
+#include "Parallel.h"
+
+#ifndef LIBS_ALIGN_H
+#define LIBS_ALIGN_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// longest decimated signal used by the coarse search (keeps its FFT small)
+const long ALIGN_COARSE_SAMPLES = 1 << 18;
+
+// longest stretch of overlap used by the full-rate fine search
+const long ALIGN_FINE_SAMPLES = 1 << 20;
+
+// box-filter decimation by factor d
+inline vector<float> decimate(const vector<float>& x, int d) {
+
+	vector<float> y(x.size() / d);
+
+	for (long k = 0; k < y.size(); ++k) {
+
+		float total = 0.0f;
+
+		for (int j = 0; j < d; ++j) {
+
+			total += x[k * d + j];
+
+		}
+
+		y[k] = total;
+
+	}
+
+	return y;
+
+}
+
+/*Cross-correlation r[lag] = sum_k x[k + lag] * y[k] for every lag in
+[-(ny - 1), nx - 1] via one FFT of each signal: R = X * conj(Y).
+Returns the lag with the largest correlation.*/
+inline long correlationPeak(const vector<float>& x, const vector<float>& y) {
+
+	long nx = x.size(), ny = y.size();
+
+	int n = FFT::nextPowerOfTwo(nx + ny);
+
+	FFT fft(n);
+
+	vector<float> xr(n), xi(n), yr(n), yi(n), workRe(n), workIm(n);
+
+	copy(x.begin(), x.end(), xr.begin());
+
+	copy(y.begin(), y.end(), yr.begin());
+
+	fft.forward(xr.data(), xi.data(), workRe.data(), workIm.data());
+
+	fft.forward(yr.data(), yi.data(), workRe.data(), workIm.data());
+
+	for (int k = 0; k < n; ++k) {
+
+		float re = xr[k] * yr[k] + xi[k] * yi[k];
+
+		float im = xi[k] * yr[k] - xr[k] * yi[k];
+
+		xr[k] = re;
+
+		xi[k] = im;
+
+	}
+
+	fft.inverse(xr.data(), xi.data(), workRe.data(), workIm.data());
+
+	long best = 0;
+
+	float bestValue = -INFINITY;
+
+	for (long lag = -(ny - 1); lag < nx; ++lag) {
+
+		float v = xr[lag >= 0 ? lag : n + lag];
+
+		if (v > bestValue) {
+
+			bestValue = v;
+
+			best = lag;
+
+		}
+
+	}
+
+	return best;
+
+}
+
+// direct correlation at one lag, over at most ALIGN_FINE_SAMPLES of the overlap
+inline double correlationAt(const vector<float>& x, const vector<float>& y,
+		long lag) {
+
+	long first = max(0L, -lag), last = min((long) y.size(),
+			(long) x.size() - lag);
+
+	last = min(last, first + ALIGN_FINE_SAMPLES);
+
+	double total = 0.0;
+
+	for (long k = first; k < last; ++k) {
+
+		total += x[k + lag] * y[k];
+
+	}
+
+	return total;
+
+}
+
+/*Find the lag (in samples) at which y best lines up with x, i.e. y[k] ~ x[k + lag]:
+a positive lag means y starts lag samples into x. The coarse search correlates
+decimated copies (short enough for one FFT); the fine search then checks every
+full-rate lag within two decimation steps of the coarse answer.*/
+inline long findLag(const vector<float>& x, const vector<float>& y) {
+
+	if (x.empty() || y.empty()) {
+
+		return 0;
+
+	}
+
+	long longest = max(x.size(), y.size());
+
+	int d = (int) max(1L, (longest + ALIGN_COARSE_SAMPLES - 1)
+			/ ALIGN_COARSE_SAMPLES);
+
+	long coarse = d > 1 ? correlationPeak(decimate(x, d), decimate(y, d)) * d :
+			correlationPeak(x, y);
+
+	if (d == 1) {
+
+		return coarse;
+
+	}
+
+	long span = 2 * d;
+
+	vector<double> score(2 * span + 1);
+
+	parallelFor(2 * span + 1, [&](long begin, long end) {
+
+		for (long k = begin; k < end; ++k) {
+
+			score[k] = correlationAt(x, y, coarse - span + k);
+
+		}
+
+	});
+
+	return coarse - span
+			+ (max_element(score.begin(), score.end()) - score.begin());
+
+}
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+//=================================================================================
+// Name        : Analysis.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Single-pass per-channel QA metrics (peak, rms, DC offset, clipping,
+// 				 zero crossings, amplitude histogram) written as JSON (-stats)
+//=================================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include "Lossless.h"
+#include "Parallel.h"
+
+#ifndef LIBS_ANALYSIS_H
+#define LIBS_ANALYSIS_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// ChannelStats struct
+/*Metrics of one channel. Everything is an integer count or sum, so the partial
+results of different threads merge exactly and the report does not depend on
+the number of threads.*/
+struct ChannelStats {
+
+	int64_t sum, sumSquares;
+
+	int minimum, maximum;
+
+	long clips, zeroCrossings;
+
+	vector<long> histogram;
+
+	ChannelStats(int bins) :
+			sum(0), sumSquares(0), minimum(INT32_MAX), maximum(INT32_MIN), clips(
+					0), zeroCrossings(0), histogram(bins, 0) {
+
+	}
+
+	void merge(const ChannelStats& o) {
+
+		sum += o.sum;
+
+		sumSquares += o.sumSquares;
+
+		minimum = min(minimum, o.minimum);
+
+		maximum = max(maximum, o.maximum);
+
+		clips += o.clips;
+
+		zeroCrossings += o.zeroCrossings;
+
+		for (int b = 0; b < histogram.size(); ++b) {
+
+			histogram[b] += o.histogram[b];
+
+		}
+
+	}
+
+};
+
+/*Analyze every channel in one pass: the frames are split over all cores, and
+each thread walks its range one block at a time, gathering a channel into a
+contiguous int block so the sum, sum of squares, min / max, clip and zero
+crossing loops vectorize. A sample is clipped when it sits at either limit of
+the sample type; a zero crossing is a sign change between consecutive samples
+(counted across block and thread boundaries too). The histogram splits the
+full sample range into `bins` equal bins.*/
+template<typename Frame> vector<ChannelStats> analyze(
+		const vector<Frame>& samples, int numChannels, int bitCount, int bins) {
+
+	const int low = -(1 << (bitCount - 1)), high = (1 << (bitCount - 1)) - 1;
+
+	const int block = 4096;
+
+	vector<ChannelStats> total(numChannels, ChannelStats(bins));
+
+	mutex merging;
+
+	parallelFor((long) samples.size(), [&](long begin, long end) {
+
+		vector<ChannelStats> part(numChannels, ChannelStats(bins));
+
+		vector<int> v(block + 1);
+
+		for (long start = begin; start < end; start += block) {
+
+			int n = (int) min((long) block, end - start);
+
+			for (int c = 0; c < numChannels; ++c) {
+
+				ChannelStats& s = part[c];
+
+				// v[0] is the sample before the block (itself at the very start)
+				v[0] = getChannel(samples[start > 0 ? start - 1 : 0], c);
+
+				for (int k = 0; k < n; ++k) {
+
+					v[k + 1] = getChannel(samples[start + k], c);
+
+				}
+
+				const int* x = v.data() + 1;
+
+				int64_t sum = 0, sumSquares = 0;
+
+				int minimum = s.minimum, maximum = s.maximum;
+
+				long clips = 0, crossings = 0;
+
+				for (int k = 0; k < n; ++k) {
+
+					sum += x[k];
+
+					sumSquares += (int64_t) x[k] * x[k];
+
+					minimum = min(minimum, x[k]);
+
+					maximum = max(maximum, x[k]);
+
+					clips += (x[k] == low) | (x[k] == high);
+
+					crossings += (x[k - 1] < 0) != (x[k] < 0);
+
+				}
+
+				for (int k = 0; k < n; ++k) {
+
+					++s.histogram[(int) (((int64_t) (x[k] - low) * bins) >> bitCount)];
+
+				}
+
+				s.sum += sum;
+
+				s.sumSquares += sumSquares;
+
+				s.minimum = minimum;
+
+				s.maximum = maximum;
+
+				s.clips += clips;
+
+				s.zeroCrossings += crossings;
+
+			}
+
+		}
+
+		lock_guard<mutex> lock(merging);
+
+		for (int c = 0; c < numChannels; ++c) {
+
+			total[c].merge(part[c]);
+
+		}
+
+	}, 1 << 16);
+
+	return total;
+
+}
+
+// sample value relative to full scale, in dB (-inf for silence)
+inline double toDbfs(double value, int bitCount) {
+
+	return 20.0 * log10(value / (1 << (bitCount - 1)));
+
+}
+
+inline void writeJsonNumber(ostream& out, double value) {
+
+	if (isfinite(value)) {
+
+		out << value;
+
+	} else {
+
+		out << "null";
+
+	}
+
+}
+
+/*Report as JSON: the clip length, then per channel the peak (absolute and dBFS),
+rms (absolute and dBFS), DC offset (mean sample value), min / max, clipped
+sample count, zero crossings (count and per second) and the histogram.*/
+inline void writeStatsJson(ostream& out, const vector<ChannelStats>& stats,
+		long numFrames, int samplingRate, int bitCount) {
+
+	const int low = -(1 << (bitCount - 1));
+
+	int bins = stats.empty() ? 0 : (int) stats[0].histogram.size();
+
+	double seconds = numFrames / (double) samplingRate;
+
+	out << "{\n  \"frames\": " << numFrames << ", \"seconds\": " << seconds
+			<< ", \"samplingRate\": " << samplingRate << ", \"bitCount\": "
+			<< bitCount << ",\n  \"channels\": [\n";
+
+	for (int c = 0; c < stats.size(); ++c) {
+
+		const ChannelStats& s = stats[c];
+
+		double n = max(numFrames, 1L);
+
+		double peak = numFrames > 0 ? max(abs(s.minimum), abs(s.maximum)) : 0;
+
+		double rms = sqrt(s.sumSquares / n);
+
+		out << "    {\"channel\": " << c + 1 << ", \"peak\": " << peak
+				<< ", \"peakDbfs\": ";
+
+		writeJsonNumber(out, toDbfs(peak, bitCount));
+
+		out << ", \"rms\": " << rms << ", \"rmsDbfs\": ";
+
+		writeJsonNumber(out, toDbfs(rms, bitCount));
+
+		out << ", \"dcOffset\": " << s.sum / n << ", \"min\": "
+				<< (numFrames > 0 ? s.minimum : 0) << ", \"max\": "
+				<< (numFrames > 0 ? s.maximum : 0) << ", \"clippedSamples\": "
+				<< s.clips << ", \"zeroCrossings\": " << s.zeroCrossings
+				<< ", \"zeroCrossingRate\": "
+				<< (seconds > 0 ? s.zeroCrossings / seconds : 0)
+				<< ",\n      \"histogram\": {\"min\": " << low << ", \"binWidth\": "
+				<< ((1 << bitCount) / max(bins, 1)) << ", \"counts\": [";
+
+		for (int b = 0; b < bins; ++b) {
+
+			out << (b > 0 ? ", " : "") << s.histogram[b];
+
+		}
+
+		out << "]}}" << (c + 1 < stats.size() ? "," : "") << "\n";
+
+	}
+
+	out << "  ]\n}\n";
+
+}
+
+}
+
+#endif
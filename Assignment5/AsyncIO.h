@@ -0,0 +1,788 @@
+//=================================================================================
+// Name        : AsyncIO.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Asynchronous file I/O: several reads / writes in flight through
+// 				 io_uring, with a worker-thread fallback
+//=================================================================================
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#ifndef LIBS_ASYNCIO_H
+#define LIBS_ASYNCIO_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// bytes per request and number of requests kept in flight
+const size_t IO_CHUNK = 1 << 20;
+
+const int IO_DEPTH = 8;
+
+// IoRequest struct
+/*One read or write of bytes [offset, offset + bytes) of fd; an offset of -1
+uses (and advances) the file position, which pipes need.*/
+struct IoRequest {
+
+	bool write;
+
+	int fd;
+
+	char* buffer;
+
+	size_t bytes;
+
+	long offset;
+
+	int tag;
+
+};
+
+// IoCompletion struct
+/*Bytes transferred by the request with the given tag, or -errno.*/
+struct IoCompletion {
+
+	int tag;
+
+	long result;
+
+};
+
+// IoQueue class
+/*Submission / completion queue for up to `depth` outstanding requests. Uses an
+io_uring instance (raw system calls, so liburing is not needed) when the kernel
+provides one with the read and write opcodes (5.6 and later), and otherwise
+`depth` worker threads doing pread / pwrite, so callers only see submit() and
+wait() either way.*/
+class IoQueue {
+
+private:
+
+	int depth, ringFd;
+
+	// io_uring: mapped submission / completion rings
+	void* sqRing;
+
+	void* cqRing;
+
+	size_t sqRingSize, cqRingSize;
+
+	unsigned sqEntries;
+
+	io_uring_sqe* sqes;
+
+	unsigned *sqHead, *sqTail, *sqMask, *sqArray, *cqHead, *cqTail, *cqMask;
+
+	io_uring_cqe* cqes;
+
+	// fallback: worker threads
+	vector<thread> workers;
+
+	deque<IoRequest> requests;
+
+	// (with the ring, only requests refused at submission)
+	deque<IoCompletion> completions;
+
+	mutex lock;
+
+	condition_variable requestReady, completionReady;
+
+	bool stopping;
+
+	static long ioUringSetup(unsigned entries, io_uring_params* p) {
+
+		return syscall(__NR_io_uring_setup, entries, p);
+
+	}
+
+	static long ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+			unsigned flags) {
+
+		return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags,
+				nullptr, 0);
+
+	}
+
+	static long ioUringRegister(int fd, unsigned opcode, void* arg, unsigned n) {
+
+		return syscall(__NR_io_uring_register, fd, opcode, arg, n);
+
+	}
+
+	/*true if the ring runs IORING_OP_READ and IORING_OP_WRITE. Kernels 5.1 - 5.5
+	set a ring up but fail those requests with -EINVAL; they also predate
+	IORING_REGISTER_PROBE, so a failed probe means no.*/
+	bool probeReadWrite() {
+
+		const unsigned numOps = 256;
+
+		vector<char> buffer(
+				sizeof(io_uring_probe) + numOps * sizeof(io_uring_probe_op), 0);
+
+		io_uring_probe* probe = (io_uring_probe*) buffer.data();
+
+		if (ioUringRegister(ringFd, IORING_REGISTER_PROBE, probe, numOps) < 0
+				|| probe->last_op < IORING_OP_WRITE) {
+
+			return false;
+
+		}
+
+		return (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0
+				&& (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) != 0;
+
+	}
+
+	// unmaps whatever part of the ring was mapped and closes it
+	void closeRing() {
+
+		if (sqes != nullptr && sqes != MAP_FAILED) {
+
+			munmap(sqes, sqEntries * sizeof(io_uring_sqe));
+
+		}
+
+		if (cqRing != nullptr && cqRing != MAP_FAILED && cqRing != sqRing) {
+
+			munmap(cqRing, cqRingSize);
+
+		}
+
+		if (sqRing != nullptr && sqRing != MAP_FAILED) {
+
+			munmap(sqRing, sqRingSize);
+
+		}
+
+		close(ringFd);
+
+		ringFd = -1;
+
+	}
+
+	/*maps the rings of a new io_uring instance; false if there is none or it
+	cannot read and write*/
+	bool setupRing() {
+
+		io_uring_params p;
+
+		memset(&p, 0, sizeof(p));
+
+		long fd = ioUringSetup(depth, &p);
+
+		if (fd < 0) {
+
+			return false;
+
+		}
+
+		ringFd = (int) fd;
+
+		sqEntries = p.sq_entries;
+
+		sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+
+		cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+
+		bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+		if (single) {
+
+			sqRingSize = cqRingSize = max(sqRingSize, cqRingSize);
+
+		}
+
+		sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+
+		cqRing = single ?
+				sqRing :
+				mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+						MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+
+		sqes = (io_uring_sqe*) mmap(nullptr,
+				p.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+
+		if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED
+				|| !probeReadWrite()) {
+
+			closeRing();
+
+			return false;
+
+		}
+
+		char* sq = (char*) sqRing;
+
+		char* cq = (char*) cqRing;
+
+		sqHead = (unsigned*) (sq + p.sq_off.head);
+
+		sqTail = (unsigned*) (sq + p.sq_off.tail);
+
+		sqMask = (unsigned*) (sq + p.sq_off.ring_mask);
+
+		sqArray = (unsigned*) (sq + p.sq_off.array);
+
+		cqHead = (unsigned*) (cq + p.cq_off.head);
+
+		cqTail = (unsigned*) (cq + p.cq_off.tail);
+
+		cqMask = (unsigned*) (cq + p.cq_off.ring_mask);
+
+		cqes = (io_uring_cqe*) (cq + p.cq_off.cqes);
+
+		return true;
+
+	}
+
+	static long transfer(const IoRequest& r) {
+
+		long n;
+
+		if (r.offset < 0) {
+
+			n = r.write ? ::write(r.fd, r.buffer, r.bytes) :
+					::read(r.fd, r.buffer, r.bytes);
+
+		} else {
+
+			n = r.write ? pwrite(r.fd, r.buffer, r.bytes, r.offset) :
+					pread(r.fd, r.buffer, r.bytes, r.offset);
+
+		}
+
+		return n < 0 ? -errno : n;
+
+	}
+
+	void work() {
+
+		unique_lock<mutex> guard(lock);
+
+		while (true) {
+
+			requestReady.wait(guard, [this] {
+				return stopping || !requests.empty();
+			});
+
+			if (requests.empty()) {
+
+				return;
+
+			}
+
+			IoRequest r = requests.front();
+
+			requests.pop_front();
+
+			guard.unlock();
+
+			IoCompletion c = { r.tag, transfer(r) };
+
+			guard.lock();
+
+			completions.push_back(c);
+
+			completionReady.notify_one();
+
+		}
+
+	}
+
+public:
+
+	// CONSTRUCTOR (ring = false forces the worker threads)
+	IoQueue(int d = IO_DEPTH, bool ring = true) :
+			depth(max(d, 1)), ringFd(-1), sqRing(nullptr), cqRing(nullptr), sqRingSize(
+					0), cqRingSize(0), sqEntries(0), sqes(nullptr), sqHead(nullptr), sqTail(
+					nullptr), sqMask(nullptr), sqArray(nullptr), cqHead(nullptr), cqTail(
+					nullptr), cqMask(nullptr), cqes(nullptr), stopping(false) {
+
+		if (ring && setupRing()) {
+
+			return;
+
+		}
+
+		for (int k = 0; k < depth; ++k) {
+
+			workers.push_back(thread([this] {
+				work();
+			}));
+
+		}
+
+	}
+
+	// DESTRUCTOR (callers wait for their requests first)
+	~IoQueue() {
+
+		if (ringFd >= 0) {
+
+			closeRing();
+
+			return;
+
+		}
+
+		{
+
+			lock_guard<mutex> guard(lock);
+
+			stopping = true;
+
+		}
+
+		requestReady.notify_all();
+
+		for (int k = 0; k < workers.size(); ++k) {
+
+			workers[k].join();
+
+		}
+
+	}
+
+	bool usingRing() const {
+
+		return ringFd >= 0;
+
+	}
+
+	int getDepth() const {
+
+		return depth;
+
+	}
+
+	// starts a request (at most `depth` may be outstanding)
+	void submit(const IoRequest& r) {
+
+		if (ringFd < 0) {
+
+			lock_guard<mutex> guard(lock);
+
+			requests.push_back(r);
+
+			requestReady.notify_one();
+
+			return;
+
+		}
+
+		unsigned tail = *sqTail;
+
+		unsigned index = tail & *sqMask;
+
+		io_uring_sqe* sqe = &sqes[index];
+
+		memset(sqe, 0, sizeof(*sqe));
+
+		sqe->opcode = r.write ? IORING_OP_WRITE : IORING_OP_READ;
+
+		sqe->fd = r.fd;
+
+		sqe->addr = (unsigned long) r.buffer;
+
+		sqe->len = (unsigned) r.bytes;
+
+		sqe->off = (unsigned long long) r.offset;
+
+		sqe->user_data = (unsigned long long) r.tag;
+
+		sqArray[index] = index;
+
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+		long n;
+
+		while ((n = ioUringEnter(ringFd, 1, 0, 0)) < 0 && errno == EINTR) {
+		}
+
+		/*Refused (e.g. EAGAIN or EBUSY while the kernel is short of resources): if
+		the entry is still unconsumed, take it back and complete the request with
+		the error, so wait() returns it instead of waiting for the kernel.*/
+		if (n <= 0
+				&& __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == tail) {
+
+			__atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+			IoCompletion c = { r.tag, n < 0 ? -errno : -EAGAIN };
+
+			completions.push_back(c);
+
+		}
+
+	}
+
+	// blocks until the next request completes
+	IoCompletion wait() {
+
+		if (ringFd < 0) {
+
+			unique_lock<mutex> guard(lock);
+
+			completionReady.wait(guard, [this] {
+				return !completions.empty();
+			});
+
+			IoCompletion c = completions.front();
+
+			completions.pop_front();
+
+			return c;
+
+		}
+
+		// requests refused at submission complete first
+		if (!completions.empty()) {
+
+			IoCompletion c = completions.front();
+
+			completions.pop_front();
+
+			return c;
+
+		}
+
+		unsigned head = *cqHead;
+
+		while (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+
+			ioUringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS);
+
+		}
+
+		io_uring_cqe* cqe = &cqes[head & *cqMask];
+
+		IoCompletion c = { (int) cqe->user_data, (long) cqe->res };
+
+		__atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+		return c;
+
+	}
+
+};
+
+// called with each piece of a read as soon as it has arrived
+typedef function<void(const char*, size_t)> ReadCallback;
+
+// AsyncFile class
+/*Reads into / writes from caller buffers in IO_CHUNK pieces with up to `depth`
+pieces in flight, so the caller can compute while the disk works. Short
+transfers are resubmitted; buffers must stay valid until finish(). An optional
+ReadCallback sees every completed read piece (in completion order, on the
+calling thread) while the later pieces are still in flight.*/
+class AsyncFile {
+
+private:
+
+	struct Slot {
+
+		IoRequest request;
+
+		// the whole piece, before any short-transfer resubmission
+		char* start;
+
+		bool busy;
+
+	};
+
+	int fd;
+
+	IoQueue queue;
+
+	vector<Slot> slots;
+
+	int outstanding;
+
+	size_t transferredBytes;
+
+	bool failed, endOfFile;
+
+	ReadCallback onRead;
+
+	// handles one completion; resubmits the rest of a short transfer
+	void reap() {
+
+		IoCompletion c = queue.wait();
+
+		Slot& slot = slots[c.tag];
+
+		IoRequest& r = slot.request;
+
+		if (c.result == -EINTR || c.result == -EAGAIN || c.result == -EBUSY) {
+
+			queue.submit(r);
+
+			return;
+
+		}
+
+		if (c.result > 0) {
+
+			transferredBytes += c.result;
+
+			r.buffer += c.result;
+
+			if (c.result < r.bytes) {
+
+				r.bytes -= c.result;
+
+				r.offset = r.offset < 0 ? -1 : r.offset + c.result;
+
+				queue.submit(r);
+
+				return;
+
+			}
+
+		} else {
+
+			failed = failed || c.result < 0 || r.write;
+
+			endOfFile = endOfFile || c.result == 0;
+
+		}
+
+		slot.busy = false;
+
+		--outstanding;
+
+		if (!r.write && onRead && r.buffer > slot.start) {
+
+			onRead(slot.start, r.buffer - slot.start);
+
+		}
+
+	}
+
+	void start(bool write, char* buffer, size_t bytes, long offset,
+			size_t granule) {
+
+		// pieces hold whole frames, so a ReadCallback never sees a split one
+		size_t chunk = max(granule, IO_CHUNK - IO_CHUNK % granule);
+
+		for (size_t done = 0; done < bytes;) {
+
+			size_t n = offset < 0 ? bytes - done : min(chunk, bytes - done);
+
+			while (outstanding == slots.size()) {
+
+				reap();
+
+			}
+
+			int tag = 0;
+
+			while (slots[tag].busy) {
+
+				++tag;
+
+			}
+
+			IoRequest r = { write, fd, buffer + done, n,
+					offset < 0 ? -1 : offset + (long) done, tag };
+
+			slots[tag].request = r;
+
+			slots[tag].start = r.buffer;
+
+			slots[tag].busy = true;
+
+			++outstanding;
+
+			queue.submit(r);
+
+			done += n;
+
+		}
+
+	}
+
+public:
+
+	// CONSTRUCTOR (depth 1 keeps the requests of a pipe in order)
+	AsyncFile(int f, int depth = IO_DEPTH, bool ring = true) :
+			fd(f), queue(depth, ring), slots(queue.getDepth()), outstanding(0), transferredBytes(
+					0), failed(false), endOfFile(false) {
+
+		for (int k = 0; k < slots.size(); ++k) {
+
+			slots[k].busy = false;
+
+		}
+
+	}
+
+	// DESTRUCTOR
+	~AsyncFile() {
+
+		finish();
+
+	}
+
+	/*bytes [offset, offset + bytes) into buffer (offset -1: from the file
+	position), in pieces that are a multiple of granule bytes*/
+	void read(char* buffer, size_t bytes, long offset, size_t granule = 1) {
+
+		start(false, buffer, bytes, offset, granule);
+
+	}
+
+	void write(const char* buffer, size_t bytes, long offset) {
+
+		start(true, (char*) buffer, bytes, offset, 1);
+
+	}
+
+	void setReadCallback(const ReadCallback& callback) {
+
+		onRead = callback;
+
+	}
+
+	// waits for every outstanding request; false if one failed
+	bool finish() {
+
+		while (outstanding > 0) {
+
+			reap();
+
+		}
+
+		return !failed;
+
+	}
+
+	// bytes read / written so far (a read stops early at the end of the file)
+	size_t transferred() const {
+
+		return transferredBytes;
+
+	}
+
+	bool atEnd() const {
+
+		return endOfFile;
+
+	}
+
+	bool usingRing() const {
+
+		return queue.usingRing();
+
+	}
+
+};
+
+/*Reads bytes [offset, offset + bytes) of a file (onRead, if set, sees each piece
+as it arrives; pieces are a multiple of granule bytes); false on error or a
+short file.*/
+inline bool readFileRange(const string& fileName, char* buffer, size_t bytes,
+		long offset, size_t granule = 1, const ReadCallback& onRead = nullptr) {
+
+	int fd = open(fileName.c_str(), O_RDONLY);
+
+	if (fd < 0) {
+
+		return false;
+
+	}
+
+	bool ok;
+
+	{
+
+		AsyncFile file(fd);
+
+		file.setReadCallback(onRead);
+
+		file.read(buffer, bytes, offset, granule);
+
+		ok = file.finish() && file.transferred() == bytes;
+
+	}
+
+	close(fd);
+
+	return ok;
+
+}
+
+/*Names of the output files this process has written, in order (--cache stores
+exactly these as the job's outputs). Every writer of job outputs notes its
+files here.*/
+inline vector<string>& writtenFiles() {
+
+	static vector<string> files;
+
+	return files;
+
+}
+
+inline void noteWrittenFile(const string& fileName) {
+
+	static mutex lock;
+
+	lock_guard<mutex> guard(lock);
+
+	writtenFiles().push_back(fileName);
+
+}
+
+// writes a buffer to a file (truncated, or appended to); false on error
+inline bool writeFile(const string& fileName, const char* buffer,
+		size_t bytes, bool append) {
+
+	int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | (append ? 0 : O_TRUNC),
+			0644);
+
+	if (fd < 0) {
+
+		return false;
+
+	}
+
+	noteWrittenFile(fileName);
+
+	struct stat st;
+
+	bool ok = fstat(fd, &st) == 0;
+
+	if (ok) {
+
+		AsyncFile file(fd);
+
+		file.write(buffer, bytes, append ? (long) st.st_size : 0);
+
+		ok = file.finish() && file.transferred() == bytes;
+
+	}
+
+	return close(fd) == 0 && ok;
+
+}
+
+}
+
+#endif
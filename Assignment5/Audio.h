@@ -15,6 +15,21 @@
 #include <math.h>
 #include <numeric>
 #include <cstdint>
+#include <limits>
+#include "Profiler.h"
+#include "Convolution.h"
+#include "Biquad.h"
+#include "Silence.h"
+#include "Fade.h"
+#include "Convert.h"
+#include "Lossless.h"
+#include "Expression.h"
+#include "Dynamics.h"
+#include "SharedSamples.h"
+#include "Frame.h"
+#include "Parallel.h"
+#include "AsyncIO.h"
+#include "Reduce.h"
 
 #ifndef LIBS_AUDIO_H
 #define LIBS_AUDIO_H
@@ -23,24 +38,254 @@ using namespace std;
 
 namespace DPLKYL002 {
 
-// 1-channel (mono) Audio class
-/*The Audio class should be templated to handle audio signals which use different
-bit sizes for samples, depending on the provided audio clips.*/
-template<typename BitCount> class Audio {
+// samples per block for block-wise processing (keeps float working copies in cache)
+const int BLOCK_FRAMES = 4096;
+
+/*Round a processed value back to the sample type, saturating at its limits.
+Rounds half away from zero exactly like roundf, but as an add of
+copysign(0.49999997, v), a branch-free clamp and a truncating conversion, so
+loops calling it vectorize (roundf has no packed form below SSE4.1).*/
+template<typename BitCount> inline BitCount saturate(float v) {
+
+	const float low = numeric_limits < BitCount >::min();
+
+	const float high = numeric_limits < BitCount >::max();
+
+	v += copysignf(0.49999997f, v);
+
+	v = v > low ? v : low;
+
+	v = v < high ? v : high;
+
+	return (BitCount) (int) v;
+
+}
+
+/*Truncate a scaled value toward zero to the sample type (as A * F does),
+saturating at its limits instead of wrapping.*/
+template<typename BitCount> inline BitCount saturateTruncate(float v) {
+
+	const float low = numeric_limits < BitCount >::min();
+
+	const float high = numeric_limits < BitCount >::max();
+
+	v = v > low ? v : low;
+
+	v = v < high ? v : high;
+
+	return (BitCount) (int) v;
+
+}
+
+/*Add n interleaved frames of N channels to per-channel ingest statistics
+(exact integer sums and extremes, so the pieces of a load may arrive in any
+order). The samples are walked as one flat array in rows of W lanes, W a
+multiple of N, and lane j belongs to channel j % N; the sums and the extremes
+get a loop each (with as many lanes as fit in registers) so both vectorize.*/
+template<typename BitCount, int N> void addIngestSamples(IngestStats& stats,
+		const BitCount* x, long n) {
+
+	const int W = N == 6 ? 24 : 16, WE = 2 * W;
+
+	int64_t sums[W];
+
+	BitCount high[WE], low[WE];
+
+	fill(sums, sums + W, 0);
+
+	fill(high, high + WE, 0);
+
+	fill(low, low + WE, 0);
+
+	long count = n * N;
+
+	for (long k = 0; k + W <= count; k += W) {
+
+		for (int j = 0; j < W; ++j) {
 
-private:
+			int32_t v = x[k + j];
 
-	vector<BitCount> vectSamples;
+			sums[j] += v * v;
+
+		}
+
+	}
+
+	for (long k = 0; k + WE <= count; k += WE) {
+
+		for (int j = 0; j < WE; ++j) {
+
+			BitCount v = x[k + j];
+
+			high[j] = v > high[j] ? v : high[j];
+
+			low[j] = v < low[j] ? v : low[j];
+
+		}
+
+	}
+
+	// the samples after the last full row of each loop
+	for (long k = count - count % W; k < count; ++k) {
+
+		int32_t v = x[k];
+
+		sums[k % W] += v * v;
+
+	}
+
+	for (long k = count - count % WE; k < count; ++k) {
+
+		high[k % WE] = max(high[k % WE], x[k]);
+
+		low[k % WE] = min(low[k % WE], x[k]);
+
+	}
+
+	for (int j = 0; j < WE; ++j) {
+
+		int c = j % N;
+
+		if (j < W) {
+
+			stats.sumSquares[c] += sums[j];
+
+		}
+
+		stats.peak[c] = max(stats.peak[c], max((int) high[j], -(int) low[j]));
+
+	}
+
+	stats.frames += n;
+
+}
+
+// ingest statistics of n frames of any layout
+template<typename S> void addIngestStats(IngestStats& stats, const S* frames,
+		long n) {
+
+	typedef typename FrameTraits<S>::sample_type BitCount;
+
+	addIngestSamples<BitCount, (int) FrameTraits<S>::channels>(stats,
+			(const BitCount*) frames, n);
+
+}
+
+/*Load n frames of a .raw file from frame `first` straight into the sample buffer
+(frames are contiguous in memory and on disk), with several reads in flight.
+With stats, each piece is added to them as soon as it arrives, while the later
+reads are still in flight and the piece is still in cache.*/
+template<typename T> void readSamples(const string& fileName, T* samples,
+		long first, long n, IngestStats* stats = nullptr) {
+
+	ReadCallback onRead;
+
+	if (stats != nullptr) {
+
+		onRead = [stats](const char* data, size_t bytes) {
+			addIngestStats(*stats, (const T*) data, bytes / sizeof(T));
+		};
+
+	}
+
+	if (!readFileRange(fileName, (char*) samples, n * sizeof(T),
+			first * sizeof(T), sizeof(T), onRead)) {
+
+		cout << "Error: unable to read [.raw] file." << endl;
+
+		exit(1);
+
+	}
+
+}
+
+// Save n frames as a .raw file (append adds them to the end of an existing one)
+template<typename T> void writeSamples(const string& fileName,
+		const T* samples, long n, bool append) {
+
+	if (!writeFile(fileName, (const char*) samples, n * sizeof(T), append)) {
+
+		cout << "Error: unable to open [.raw] file." << endl;
+
+		exit(1);
+
+	}
+
+}
+
+/*The name saveAudioFile gives a clip, before its .raw or .slac extension:
+<prefix>_<rate>_<bits>_mono, _stereo or _<N>ch.*/
+inline string audioFileName(const string& prefix, int samplingRate,
+		int bitCount, int numChannels) {
+
+	return prefix + "_" + to_string(samplingRate) + "_" + to_string(bitCount)
+			+ (numChannels == 1 ? "_mono" :
+				numChannels == 2 ? "_stereo" : "_" + to_string(numChannels) + "ch");
+
+}
+
+/*One implementation of the Audio operations for every channel layout. Sample is
+a mono sample (BitCount), a stereo pair or a Frame<BitCount, N>; the work inside
+a frame goes through channelSample in forEachChannel, so it is unrolled over the
+N channels, and the loops over frames run straight over the contiguous samples.
+Per-channel arguments are std::arrays of N values. Audio<Sample> derives from
+it, and the mono and stereo classes only add their float and pair forms.*/
+template<typename Sample> class BasicAudio: public AudioExpression<Audio<Sample>> {
+
+public:
+
+	typedef typename FrameTraits<Sample>::sample_type BitCount;
+
+	static const size_t N = FrameTraits<Sample>::channels;
+
+protected:
+
+	SharedSamples<Sample> vectSamples;
 
 	int numChannels, samplingRate, numSamples, lengthAudioClip;
 
+	// the Audio this implements (in-place operations return it)
+	Audio<Sample>& derived() {
+
+		return static_cast<Audio<Sample>&>(*this);
+
+	}
+
+	const Audio<Sample>& derived() const {
+
+		return static_cast<const Audio<Sample>&>(*this);
+
+	}
+
 public:
 
 	// THE BIG 6
 
 	// CONSTRUCTORS
-	Audio(const string& inputFileName, int& sRate) :
-			numChannels(1), samplingRate(sRate) {
+	/*Loads frames [first, last) of a .raw or .slac file (by default all of it);
+	a .slac file only decodes the frames overlapping the range, and frames are
+	contiguous, so a .raw range is a single read. withStats gathers IngestStats
+	while a .raw file loads, so computeRMS needs no pass.*/
+	BasicAudio(const string& inputFileName, int& sRate, long first = 0,
+			long last = -1, bool withStats = false) :
+			numChannels(N), samplingRate(sRate) {
+
+		ScopedStage stage("load");
+
+		if (isLosslessFile(inputFileName)) {
+
+			vectSamples = readLossless<Sample>(inputFileName,
+					sizeof(BitCount) * 8, numChannels, first, last);
+
+			this->numSamples = vectSamples.size();
+
+			this->lengthAudioClip = (int) (numSamples / ((float) sRate));
+
+			stage.setWork(numSamples * sizeof(Sample), numSamples);
+
+			return;
+
+		}
 
 		ifstream iFile(inputFileName, ios::binary | ios::in);
 
@@ -48,22 +293,34 @@ public:
 
 			long s = getAudioFileSize(inputFileName);
 
-			this->numSamples = s / (sizeof(BitCount));
+			long total = s / (sizeof(Sample));
+
+			last = last < 0 ? total : min(last, total);
+
+			first = max(0L, min(first, last));
+
+			this->numSamples = last - first;
 
 			this->lengthAudioClip = (int) (numSamples / ((float) sRate));
 
+			stage.setWork(numSamples * sizeof(Sample), numSamples);
+
+			iFile.close();
+
 			vectSamples.resize(numSamples);
 
-			for (int k = 0; k < numSamples; ++k) {
+			shared_ptr<IngestStats> stats;
 
-				BitCount b;
+			if (withStats) {
 
-				iFile.read((char *) &b, sizeof(BitCount));
+				stats = make_shared<IngestStats>(numChannels);
 
-				vectSamples[k] = b;
 			}
 
-			iFile.close();
+			readSamples(inputFileName, vectSamples.data(), first, numSamples,
+					stats.get());
+
+			vectSamples.setStats(stats);
 
 		} else {
 
@@ -75,14 +332,14 @@ public:
 
 	}
 
-	Audio(int nSamples, int lengthAC, vector<BitCount> v, int& nChannels,
-			int& sRate) :
+	BasicAudio(int nSamples, int lengthAC, vector<Sample> v,
+			const int& nChannels, const int& sRate) :
 			numChannels(nChannels), samplingRate(sRate), numSamples(nSamples), lengthAudioClip(
-					lengthAC), vectSamples(v) {
+					lengthAC), vectSamples(move(v)) {
 	}
 
 	// DESTRUCTOR
-	~Audio() {
+	~BasicAudio() {
 
 		numChannels = 0;
 
@@ -94,12 +351,10 @@ public:
 
 		vectSamples.clear();
 
-		vector<BitCount>().swap(vectSamples);
-
 	}
 
 	// MOVE CONTRUCTOR
-	Audio(Audio&& oAudio) :
+	BasicAudio(BasicAudio&& oAudio) :
 			numChannels(oAudio.numChannels), samplingRate(oAudio.samplingRate), numSamples(
 					oAudio.numSamples), lengthAudioClip(oAudio.lengthAudioClip), vectSamples(
 					oAudio.vectSamples) {
@@ -117,7 +372,9 @@ public:
 	}
 
 	// MOVE ASSIGNMENT OPERATOR
-	Audio& operator =(Audio&& oAudio) {
+	BasicAudio& operator =(BasicAudio&& oAudio) {
+
+		numChannels = oAudio.numChannels;
 
 		samplingRate = oAudio.samplingRate;
 
@@ -137,18 +394,22 @@ public:
 
 		oAudio.vectSamples.clear();
 
+		return *this;
+
 	}
 
 	// COPY CONTRUCTOR
-	Audio(const Audio& oAudio) :
-		numChannels(oAudio.numChannels), samplingRate(oAudio.samplingRate), numSamples(
-				oAudio.numSamples), lengthAudioClip(oAudio.lengthAudioClip), vectSamples(
-				oAudio.vectSamples) {
+	BasicAudio(const BasicAudio& oAudio) :
+			numChannels(oAudio.numChannels), samplingRate(oAudio.samplingRate), numSamples(
+					oAudio.numSamples), lengthAudioClip(oAudio.lengthAudioClip), vectSamples(
+					oAudio.vectSamples) {
 
 	}
 
 	// COPY ASSIGNMENT OPERATOR
-	Audio& operator =(const Audio& oAudio) {
+	BasicAudio& operator =(const BasicAudio& oAudio) {
+
+		numChannels = oAudio.numChannels;
 
 		samplingRate = oAudio.samplingRate;
 
@@ -158,52 +419,123 @@ public:
 
 		vectSamples = oAudio.vectSamples;
 
+		return *this;
+
+	}
+
+	// EXPRESSION CONSTRUCTOR (evaluates A + B and A * F chains in one loop)
+	template<typename E> BasicAudio(const AudioExpression<E>& expression) :
+			numChannels(N), samplingRate(0), numSamples(0), lengthAudioClip(0) {
+
+		*this = expression;
+
+	}
+
+	// EXPRESSION ASSIGNMENT OPERATOR
+	template<typename E> Audio<Sample>& operator =(
+			const AudioExpression<E>& expression) {
+
+		const E& e = expression.self();
+
+		ScopedStage stage("evaluate", e.size() * sizeof(Sample), e.size());
+
+		samplingRate = e.getSamplingRate();
+
+		// a shared buffer is replaced rather than copied and then overwritten
+		if (vectSamples.shared()) {
+
+			vector<Sample> b;
+
+			evaluateExpression(e, b);
+
+			vectSamples = move(b);
+
+		} else {
+
+			evaluateExpression(e, vectSamples.write());
+
+		}
+
+		numSamples = vectSamples.size();
+
+		lengthAudioClip = (int) (numSamples / ((float) samplingRate));
+
+		return derived();
+
 	}
 
 	// UTILITY FUNCTIONS
 
-	// GET SIZE
-	long getAudioFileSize(const string& inputFileName) {
+	// GET SAMPLES
+	const vector<Sample>& getSamples() const {
 
-		ifstream iFile(inputFileName, ifstream::ate | std::ifstream::binary);
+		return vectSamples.read();
 
-		return (long) iFile.tellg();
+	}
+
+	// GET SAMPLING RATE
+	int getSamplingRate() const {
+
+		return samplingRate;
 
 	}
 
-	// SAVE
-	void saveAudioFile(const string& inputFileName) {
+	// ELEMENT ACCESS (lets an Audio be an operand of A + B and A * F expressions)
+	typedef Sample value_type;
 
-		string newFileName = inputFileName + "_" + to_string(samplingRate) + "_"
-				+ to_string(sizeof(BitCount) * 8) + "_mono.raw";
+	const Sample& operator[](long k) const {
 
-		ofstream oFile(newFileName, ios::binary | ios::out);
+		return vectSamples[k];
 
-		if (oFile.is_open()) {
+	}
 
-			for (int k = 0; k < vectSamples.size(); ++k) {
+	long size() const {
 
-				oFile.write(reinterpret_cast<const char *>(&vectSamples[k]),
-						sizeof(BitCount));
+		return vectSamples.size();
 
-			}
+	}
 
-		} else {
+	// GET SIZE
+	long getAudioFileSize(const string& inputFileName) {
 
-			cout << "Error: unable to open [.raw] file." << endl;
+		ifstream iFile(inputFileName, ifstream::ate | std::ifstream::binary);
 
-			exit(1);
+		return (long) iFile.tellg();
+
+	}
+
+	// SAVE (append adds the samples to the end of an existing .raw file)
+	void saveAudioFile(const string& inputFileName, bool append = false) const {
+
+		string newFileName = audioFileName(inputFileName, samplingRate,
+				sizeof(BitCount) * 8, N);
+
+		ScopedStage stage("save", vectSamples.size() * sizeof(Sample),
+				vectSamples.size());
+
+		if (losslessOutput()) {
+
+			writeLossless(newFileName + ".slac", vectSamples.read(),
+					sizeof(BitCount) * 8, numChannels, samplingRate);
+
+			return;
 
 		}
 
+		writeSamples(newFileName + ".raw", vectSamples.data(), vectSamples.size(),
+				append);
+
 	}
 
 	// OPERATORS
 
 	// A | B: concatenate audio file A and B
-	Audio operator |(const Audio& oAudio) {
+	Audio<Sample> operator |(const Audio<Sample>& oAudio) const {
 
-		Audio audio(*this);
+		ScopedStage stage("operator|", (numSamples + oAudio.numSamples) * sizeof(Sample),
+				numSamples + oAudio.numSamples);
+
+		Audio<Sample> audio(derived());
 
 		audio.vectSamples.insert(audio.vectSamples.end(),
 				oAudio.vectSamples.begin(), oAudio.vectSamples.end());
@@ -216,589 +548,833 @@ public:
 
 	}
 
-	/*A * F: volume factor A with F; F will be a std::pair<float,float> with each float
-	value in range [0.0,1.0]*/
-	Audio operator *(float vol) {
+	/*Crossfade: A | B with the end of A faded out under the start of B
+	(equal-power), in one pass over both clips and without building faded
+	copies. Each channel has its own fade length; the fades are centred in an
+	overlap as long as the longest of them.*/
+	Audio<Sample> crossfade(const Audio<Sample>& oAudio,
+			const array<int, N>& overlap) const {
 
-		Audio audio(*this);
+		ScopedStage stage("crossfade",
+				(numSamples + oAudio.numSamples) * sizeof(Sample),
+				numSamples + oAudio.numSamples);
 
-		transform(this->vectSamples.begin(), this->vectSamples.end(),
-				audio.vectSamples.begin(), [vol](BitCount b) {return b*vol;});
+		long w = min((long) *max_element(overlap.begin(), overlap.end()),
+				(long) min(vectSamples.size(), oAudio.vectSamples.size()));
 
-		return audio;
+		// channels with the same fade share one set of gains
+		bool sameFade = true;
 
-	}
+		for (size_t c = 0; c < N; ++c) {
 
-	// A+B: add sound file amplitudes together (per sample)
-	Audio operator +(const Audio& oAudio) {
+			sameFade = sameFade && min((long) overlap[c], w) == min((long) overlap[0], w);
 
-		Audio audio(*this);
+		}
+
+		const int fades = sameFade ? 1 : N, stride = sameFade ? 0 : BLOCK_FRAMES;
+
+		long head = vectSamples.size() - w;
+
+		vector<Sample> b;
+
+		b.reserve(head + oAudio.vectSamples.size());
+
+		b.insert(b.end(), vectSamples.begin(), vectSamples.begin() + head);
+
+		b.resize(head + w);
 
-		for (int k = 0; k < vectSamples.size(); ++k) {
+		vector<float> gainOut(BLOCK_FRAMES * fades), gainIn(BLOCK_FRAMES * fades);
 
-			BitCount b = vectSamples[k] + oAudio.vectSamples[k];
+		for (long start = 0; start < w; start += BLOCK_FRAMES) {
 
-			if (b > numeric_limits < BitCount >::max()) {
+			int n = (int) min((long) BLOCK_FRAMES, w - start);
 
-				b = numeric_limits < BitCount >::max();
+			for (int c = 0; c < fades; ++c) {
+
+				crossfadeGains(start, n, w, min((long) overlap[c], w),
+						gainOut.data() + c * BLOCK_FRAMES, gainIn.data() + c * BLOCK_FRAMES);
 
 			}
 
-			audio.vectSamples[k] = b;
+			const Sample* x = vectSamples.data() + head + start;
+
+			const Sample* y = oAudio.vectSamples.data() + start;
+
+			Sample* out = b.data() + head + start;
+
+			const float* gOut = gainOut.data(), *gIn = gainIn.data();
+
+			for (int k = 0; k < n; ++k) {
+
+				forEachChannel<N>([&](size_t c) {
+
+					channelSample(out[k], c) = saturate<BitCount>(
+							channelSample(x[k], c) * gOut[c * stride + k]
+									+ channelSample(y[k], c) * gIn[c * stride + k]);
+
+				});
+
+			}
 
 		}
 
-		return audio;
+		b.insert(b.end(), oAudio.vectSamples.begin() + w,
+				oAudio.vectSamples.end());
+
+		int nSamples = (int) b.size();
+
+		int newLength = (int) (nSamples / ((float) samplingRate));
+
+		return Audio<Sample>(nSamples, newLength, move(b), numChannels,
+				samplingRate);
+
+	}
+
+	// Crossfade with the same fade length on every channel
+	Audio<Sample> crossfade(const Audio<Sample>& oAudio, int overlap) const {
+
+		array<int, N> overlaps;
+
+		overlaps.fill(overlap);
+
+		return crossfade(oAudio, overlaps);
 
 	}
 
 	/*A^F: F will be a std::pair<int,int> which specifies start and end sample of range
 	of samples to be cut from sound file A. This implements a cut operation which
-	produces a shorter clip (A with a portion removed).*/
-	Audio operator ^(pair<int, int> range) {
+	produces a shorter clip (A with a portion removed). The two kept ranges are
+	copied whole.*/
+	Audio<Sample> operator ^(pair<int, int> range) const {
 
-		int numSamplesCut = numSamples - (range.second - range.first) - 1;
+		ScopedStage stage("operator^", (numSamples) * sizeof(Sample),
+				numSamples);
 
-		int newLength = (int) (numSamplesCut / ((float) samplingRate));
+		long size = vectSamples.size();
 
-		vector<BitCount> b;
+		long cutFirst = max(0L, min((long) range.first, size));
 
-		for (int k = 0; k < vectSamples.size(); ++k) {
+		long cutEnd = max(cutFirst, min((long) range.second + 1, size));
 
-			if (k < range.first || k > range.second) {
+		vector<Sample> b;
 
-				b.push_back(vectSamples[k]);
+		b.reserve(size - (cutEnd - cutFirst));
 
-			}
+		b.insert(b.end(), vectSamples.begin(), vectSamples.begin() + cutFirst);
 
-		}
+		b.insert(b.end(), vectSamples.begin() + cutEnd, vectSamples.end());
 
-		Audio<BitCount> audio(numSamplesCut, newLength, b, numChannels,
-				samplingRate);
+		int numSamplesCut = (int) b.size();
 
-		return audio;
+		int newLength = (int) (numSamplesCut / ((float) samplingRate));
+
+		return Audio<Sample>(numSamplesCut, newLength, move(b), numChannels,
+				samplingRate);
 
 	}
 
 	// AUDIO TRANSFORMATION
 
 	/*Reverse: reverse all samples (this can be done very quickly with the
-	STL)*/
+	STL); the channels of a frame keep their order.*/
 	void revOrdering() {
 
+		ScopedStage stage("revOrdering", (numSamples) * sizeof(Sample),
+				numSamples);
+
 		reverse(vectSamples.begin(), vectSamples.end());
 
 	}
 
-	/*Sound normalization: Use std::transform with a custom functor to
-	normalize the sound files to the specified desired rms value (per channel).*/
-	Audio& normalizeSound(float RMSVal) {
+	/*Sound normalization: scale each channel to the desired rms value (one per
+	channel).*/
+	Audio<Sample>& normalizeSound(const array<float, N>& RMSVal) {
 
-		float rms = computeRMS();
+		ScopedStage stage("normalizeSound", (numSamples) * sizeof(Sample),
+				numSamples);
 
-		// formula
-		transform(vectSamples.begin(), vectSamples.end(),
-				vectSamples.begin(), Normalize(RMSVal, rms));
+		return normalizeSound(RMSVal, channelRMS());
 
-		return *this;
+	}
+
+	/*Sound normalization against known current rms values (e.g. the running rms
+	of a growing recording, see Incremental.h). Scaled samples are truncated,
+	like A * F.*/
+	Audio<Sample>& normalizeSound(const array<float, N>& RMSVal,
+			const array<float, N>& rms) {
+
+		array<float, N> gain;
+
+		for (size_t c = 0; c < N; ++c) {
+
+			gain[c] = RMSVal[c] / rms[c];
+
+		}
+
+		Sample* samples = vectSamples.data();
+
+		for (long k = 0; k < (long) vectSamples.size(); ++k) {
+
+			forEachChannel<N>([&](size_t c) {
+
+				channelSample(samples[k], c) = saturateTruncate<BitCount>(
+						channelSample(samples[k], c) * gain[c]);
+
+			});
+
+		}
+
+		return derived();
 
 	}
 
 	/*Ranged add: select two (same length) sample ranges from two signals
 	and add them together. This differs from the overloaded + which adds
 	entire audio clips together.*/
-	Audio rangedAdd(const Audio& oAudio, pair<int, int> r) {
+	Audio<Sample> rangedAdd(const Audio<Sample>& oAudio, pair<int, int> r) const {
 
-		Audio audio(*this);
+		ScopedStage stage("rangedAdd", (numSamples) * sizeof(Sample),
+				numSamples);
 
-		Audio audioExtractFirst(*this);
+		Audio<Sample> audio(derived());
 
-		audioExtractFirst.vectSamples.clear();
+		Sample* out = audio.vectSamples.data();
 
-		audioExtractFirst.vectSamples.resize(r.second - r.first);
+		const Sample* y = oAudio.vectSamples.data();
 
-		copy(vectSamples.begin() + r.first, vectSamples.begin() + r.second,
-				audioExtractFirst.vectSamples.begin());
+		long last = min((long) r.second,
+				(long) min(vectSamples.size(), oAudio.vectSamples.size()));
 
-		Audio audioExtractSecond(oAudio);
+		for (long k = max(0, r.first); k < last; ++k) {
 
-		audioExtractSecond.vectSamples.clear();
+			out[k] = addSample(out[k], y[k]);
 
-		audioExtractSecond.vectSamples.resize(r.second - r.first);
+		}
 
-		copy(oAudio.vectSamples.begin() + r.first,
-				oAudio.vectSamples.begin() + r.second,
-				audioExtractSecond.vectSamples.begin());
+		return audio;
 
-		Audio total = audioExtractFirst + audioExtractSecond;
+	}
 
-		copy(total.vectSamples.begin(), total.vectSamples.end(),
-				audio.vectSamples.begin() + r.first);
+	/*Shift: a copy with channel c delayed by lag[c] samples (advanced when
+	negative), zero-padded or cut to `length` samples.*/
+	Audio<Sample> shifted(const array<long, N>& lag, int length) const {
 
-		return audio;
+		ScopedStage stage("shifted", length * sizeof(Sample), length);
 
-	}
+		vector<Sample> b(length, Sample());
 
-	/*Compute RMS: use std::accumulate in <numeric> along with a custom
-	lambda to compute the RMS (per channel)*/
-	float computeRMS() {
+		const Sample* in = vectSamples.data();
 
-		float val = 0.0;
+		Sample* out = b.data();
 
-		// formula
-		float totalSum = accumulate(vectSamples.begin(), vectSamples.end(), val,
-				[](float total, const BitCount& b) {
-					return (total + ( pow(b, 2) ));
-				});
+		for (size_t c = 0; c < N; ++c) {
+
+			long first = max(0L, lag[c]), last = min((long) length,
+					(long) vectSamples.size() + lag[c]);
+
+			for (long k = first; k < last; ++k) {
+
+				channelSample(out[k], c) = channelSample(in[k - lag[c]], c);
 
-		totalSum = (float) sqrt(totalSum / ((float) numSamples));
+			}
+
+		}
 
-		return totalSum;
+		int newLength = (int) (length / ((float) samplingRate));
+
+		return Audio<Sample>(length, newLength, move(b), numChannels,
+				samplingRate);
 
 	}
 
-	// Normalize class
-	class Normalize {
+	/*Silence: runs of at least minSamples frames where every channel stays below
+	threshold, as [first, last) sample ranges.*/
+	vector<pair<long, long>> findSilence(int threshold, long minSamples) const {
 
-	private:
+		ScopedStage stage("findSilence", numSamples * sizeof(Sample),
+				numSamples);
 
-		float newValue, value;
+		const Sample* s = vectSamples.data();
 
-	public:
+		return findSilentRuns((long) vectSamples.size(), [s](long k) {
 
-		// CONSTRUCTOR
-		Normalize(float n, float v) :
-				newValue(n), value(v) {
+			int peak = 0;
 
-		}
+			forEachChannel<N>([&](size_t c) {
 
-		// OPERATOR
-		BitCount operator()(BitCount b) {
+				int v = channelSample(s[k], c);
 
-			BitCount bCount = (BitCount) (b * (newValue / value));
+				peak = max(peak, v < 0 ? -v : v);
 
-			if (bCount > numeric_limits < BitCount >::max()) {
+			});
 
-				bCount = numeric_limits < BitCount >::max();
+			return peak;
 
-			}
+		}, threshold, minSamples);
 
-			return bCount;
+	}
+
+	/*Trim: remove leading and trailing silence in place (see findSilence).*/
+	Audio<Sample>& trimSilence(int threshold, long minSamples) {
+
+		vector<pair<long, long>> runs = findSilence(threshold, minSamples);
+
+		ScopedStage stage("trimSilence", numSamples * sizeof(Sample),
+				numSamples);
+
+		if (!runs.empty() && runs.back().second == vectSamples.size()) {
+
+			vectSamples.erase(vectSamples.begin() + runs.back().first,
+					vectSamples.end());
 
 		}
 
-	};
+		if (!runs.empty() && runs.front().first == 0 && !vectSamples.empty()) {
 
-};
+			vectSamples.erase(vectSamples.begin(),
+					vectSamples.begin() + runs.front().second);
 
-// 2-channel (stereo) Audio class
-/*The Audio class should be templated to handle audio signals which use different
-bit sizes for samples, depending on the provided audio clips.*/
-template<typename BitCount> class Audio<pair<BitCount, BitCount>> {
+		}
 
-private:
+		numSamples = (int) vectSamples.size();
 
-	vector<pair<BitCount, BitCount>> vectSamples;
+		lengthAudioClip = (int) (numSamples / ((float) samplingRate));
 
-	int numChannels, samplingRate, numSamples, lengthAudioClip;
+		return derived();
 
-public:
+	}
 
-	// THE BIG 6
+	/*Filter: run every channel through a biquad cascade (built for N channels)
+	in place, one block at a time; a stereo chain runs both channels together.
+	The filter state lives in the chain, so successive calls continue the same
+	signal.*/
+	Audio<Sample>& filter(BiquadChain& chain) {
 
-	// CONSTRUCTORS
-	Audio(const string& inputFileName, int& sRate) :
-			numChannels(2), samplingRate(sRate) {
+		ScopedStage stage("filter", numSamples * sizeof(Sample), numSamples);
 
-		ifstream iFile(inputFileName, ios::binary | ios::in);
+		vector<float> blocks(BLOCK_FRAMES * N);
 
-		if (iFile.is_open()) {
+		// one copy-on-write check for the whole pass, not one per sample
+		Sample* samples = vectSamples.data();
 
-			long s = getAudioFileSize(inputFileName);
+		for (int start = 0; start < vectSamples.size(); start += BLOCK_FRAMES) {
 
-			this->numSamples = s / (sizeof(BitCount) * numChannels);
+			int n = min(BLOCK_FRAMES, (int) vectSamples.size() - start);
 
-			this->lengthAudioClip = (int) (numSamples / ((float) sRate));
+			Sample* frames = samples + start;
 
-			vectSamples.resize(numSamples);
+			float* block = blocks.data();
+
+			for (int k = 0; k < n; ++k) {
+
+				forEachChannel<N>([&](size_t c) {
 
-			for (int k = 0; k < numSamples; ++k) {
+					block[c * BLOCK_FRAMES + k] = channelSample(frames[k], c);
 
-				BitCount b;
+				});
+
+			}
+
+			if (N == 2) {
 
-				iFile.read((char *) &b, sizeof(BitCount));
+				chain.processStereo(blocks.data(), blocks.data() + BLOCK_FRAMES, n);
 
-				BitCount bS;
+			} else {
 
-				iFile.read((char *) &bS, sizeof(BitCount));
+				for (size_t c = 0; c < N; ++c) {
 
-				vectSamples[k] = (make_pair(b, bS));
+					chain.process(blocks.data() + c * BLOCK_FRAMES, n, (int) c);
+
+				}
 
 			}
 
-			iFile.close();
+			for (int k = 0; k < n; ++k) {
 
-		} else {
+				forEachChannel<N>([&](size_t c) {
 
-			cout << "Error: unable to open [.raw] file." << endl;
+					channelSample(frames[k], c) = saturate<BitCount>(
+							block[c * BLOCK_FRAMES + k]);
 
-			exit(1);
+				});
+
+			}
 
 		}
+
+		return derived();
+
 	}
 
+	/*Envelope: scale every channel in place by a gain envelope (fades, keyframed
+	volume automation). The envelope is stateless, so the frames are split over
+	all cores and each thread generates its gains one block at a time and applies
+	them in a separate loop that vectorizes.*/
+	Audio<Sample>& envelope(const GainEnvelope& env) {
 
-	Audio(int nSamples, int lengthAC, vector<pair<BitCount, BitCount>> vSamples,
-			int& nChannels, int& sRate) :
-			numChannels(nChannels), samplingRate(sRate), numSamples(nSamples), lengthAudioClip(
-					lengthAC), vectSamples(vSamples) {
+		ScopedStage stage("envelope", numSamples * sizeof(Sample), numSamples);
 
-	}
+		Sample* samples = vectSamples.data();
 
-	// DESTRUCTOR
-	~Audio() {
+		parallelFor((long) vectSamples.size(),
+				[&env, samples](long begin, long end) {
 
-		numChannels = 0;
+			vector<float> gain(BLOCK_FRAMES);
 
-		samplingRate = 0;
+			for (long start = begin; start < end; start += BLOCK_FRAMES) {
 
-		numSamples = 0;
+				int n = (int) min((long) BLOCK_FRAMES, end - start);
 
-		lengthAudioClip = 0;
+				env.gains(start, n, gain.data());
 
-		vectSamples.clear();
+				Sample* block = samples + start;
 
-		vector<pair<BitCount, BitCount>>().swap(vectSamples);
+				for (int k = 0; k < n; ++k) {
 
-	}
+					float g = gain[k];
 
-	// MOVE CONTRUCTOR
-	Audio(Audio&& oAudio) :
-			numChannels(oAudio.numChannels), samplingRate(oAudio.samplingRate), numSamples(
-					oAudio.numSamples), lengthAudioClip(oAudio.lengthAudioClip), vectSamples(
-					oAudio.vectSamples) {
+					forEachChannel<N>([&](size_t c) {
 
-		oAudio.numChannels = 0;
+						channelSample(block[k], c) = saturate<BitCount>(
+								channelSample(block[k], c) * g);
 
-		oAudio.samplingRate = 0;
+					});
 
-		oAudio.numSamples = 0;
+				}
 
-		oAudio.lengthAudioClip = 0;
+			}
 
-		oAudio.vectSamples.clear();
+		}, 1 << 16);
+
+		return derived();
 
 	}
 
-	// MOVE ASSIGNMENT OPERATOR
-	Audio& operator =(Audio&& oAudio) {
+	/*Compress: run every channel through a compressor / limiter in place. Gains
+	are generated one block at a time and then applied in a separate, branch-free
+	loop. Linked, the detector follows the loudest channel and one gain is
+	applied to all of them (the image stays put); unlinked, each channel has its
+	own copy of the compressor.*/
+	Audio<Sample>& compress(Compressor& compressor, bool linked = true) {
 
-		samplingRate = oAudio.samplingRate;
+		ScopedStage stage("compress", numSamples * sizeof(Sample), numSamples);
 
-		numSamples = oAudio.numSamples;
+		vector<Compressor> others(linked ? 0 : N - 1, compressor);
 
-		lengthAudioClip = oAudio.lengthAudioClip;
+		const Sample* samples = vectSamples.data();
 
-		vectSamples = oAudio.vectSamples;
+		const float scale = 1.0f / numeric_limits < BitCount >::max();
 
-		oAudio.numChannels = 0;
+		vector<float> gains(BLOCK_FRAMES * N);
 
-		oAudio.samplingRate = 0;
+		for (int start = 0; start < vectSamples.size(); start += BLOCK_FRAMES) {
 
-		oAudio.numSamples = 0;
+			int n = min(BLOCK_FRAMES, (int) vectSamples.size() - start);
 
-		oAudio.lengthAudioClip = 0;
+			if (linked) {
 
-		oAudio.vectSamples.clear();
+				compressor.gains(start, n, vectSamples.size(),
+						[samples, scale](long k) {
 
-	}
+							float peak = 0.0f;
 
-	// COPY CONTRUCTOR
-	Audio(const Audio& oAudio) :
-		numChannels(oAudio.numChannels), samplingRate(oAudio.samplingRate), numSamples(
-				oAudio.numSamples), lengthAudioClip(oAudio.lengthAudioClip), vectSamples(
-				oAudio.vectSamples) {
+							forEachChannel<N>([&](size_t c) {
 
-	}
+								peak = max(peak, fabsf(channelSample(samples[k], c)));
 
-	// COPY ASSIGNMENT OPERATOR
-	Audio& operator =(const Audio& oAudio) {
+							});
 
-		samplingRate = oAudio.samplingRate;
+							return peak * scale;
 
-		numSamples = oAudio.numSamples;
+						}, gains.data());
 
-		lengthAudioClip = oAudio.lengthAudioClip;
+			} else {
 
-		vectSamples = oAudio.vectSamples;
+				for (size_t c = 0; c < N; ++c) {
 
-	}
+					(c == 0 ? compressor : others[c - 1]).gains(start, n,
+							vectSamples.size(), [samples, scale, c](long k) {
 
-	// UTILITY FUNCTIONS
+								return fabsf(channelSample(samples[k], c)) * scale;
 
-	// GET SIZE
-	long getAudioFileSize(const string& inputFileName) {
+							}, gains.data() + c * BLOCK_FRAMES);
 
-		ifstream iFile(inputFileName, ifstream::ate | ifstream::binary);
+				}
 
-		return (long) iFile.tellg();
+			}
+
+			const float* g = gains.data();
+
+			const int stride = linked ? 0 : BLOCK_FRAMES;
+
+			Sample* block = vectSamples.data() + start;
+
+			for (int k = 0; k < n; ++k) {
+
+				forEachChannel<N>([&](size_t c) {
+
+					channelSample(block[k], c) = saturate<BitCount>(
+							channelSample(block[k], c) * g[c * stride + k]);
+
+				});
+
+			}
+
+		}
+
+		return derived();
 
 	}
 
-	// SAVE
-	void saveAudioFile(const string& inputFileName) {
+	/*Convolve: filter each channel with the matching channel of an impulse
+	response (FIR taps or a room response) read from a .raw file of the same
+	format. Impulse samples are fixed-point gains in [-1, 1); the result keeps
+	the full N + M - 1 tail.*/
+	Audio<Sample> convolve(const Audio<Sample>& oImpulse) const {
+
+		ScopedStage stage("convolve", numSamples * sizeof(Sample), numSamples);
 
-		string newFileName = inputFileName + "_" + to_string(samplingRate) + "_"
-				+ to_string(sizeof(BitCount) * 8) + "_stereo.raw";
+		float scale = 1.0f / ((float) numeric_limits < BitCount >::max() + 1);
 
-		ofstream oFile(newFileName, ios::binary | ios::out);
+		long n = vectSamples.size(), m = oImpulse.vectSamples.size();
 
-		if (oFile.is_open()) {
+		const Sample* in = vectSamples.data();
 
-			for (int k = 0; k < vectSamples.size(); ++k) {
+		const Sample* impulse = oImpulse.vectSamples.data();
 
-				oFile.write(
+		vector<float> x(n), h(m);
 
-						reinterpret_cast<const char *>(&vectSamples[k].first),
-						sizeof(BitCount));
+		vector<Sample> b;
 
-				oFile.write(
-						reinterpret_cast<const char *>(&vectSamples[k].second),
-						sizeof(BitCount));
+		for (size_t c = 0; c < N; ++c) {
+
+			for (long k = 0; k < n; ++k) {
+
+				x[k] = channelSample(in[k], c);
 
 			}
 
-		} else {
+			for (long k = 0; k < m; ++k) {
 
-			cout << "Error: unable to open [.raw] file." << endl;
+				h[k] = channelSample(impulse[k], c) * scale;
 
-			exit(1);
+			}
+
+			vector<float> y = fftConvolve(x, h);
+
+			b.resize(y.size());
+
+			for (long k = 0; k < (long) y.size(); ++k) {
+
+				channelSample(b[k], c) = saturate<BitCount>(y[k]);
+
+			}
 
 		}
+
+		int nSamples = (int) b.size();
+
+		int newLength = (int) (nSamples / ((float) samplingRate));
+
+		return Audio<Sample>(nSamples, newLength, move(b), numChannels,
+				samplingRate);
+
 	}
 
-	// OPERATORS
+	/*RMS of each channel: the squares are summed exactly as 64-bit integers
+	(which keeps the loop vectorizable) over fixed-size blocks spread over all
+	cores (reduceBlocks), so the result does not drift with the clip length and
+	is the same for any number of threads.*/
+	array<float, N> channelRMS() const {
 
-	// A | B: concatenate audio file A and B
-	Audio operator |(const Audio& oAudio) {
+		ScopedStage stage("computeRMS", (numSamples) * sizeof(Sample),
+				numSamples);
 
-		Audio audio(*this);
+		array<float, N> rms;
 
-		audio.vectSamples.insert(audio.vectSamples.end(),
-				oAudio.vectSamples.begin(), oAudio.vectSamples.end());
+		const IngestStats* stats = vectSamples.getStats();
 
-		audio.lengthAudioClip = audio.lengthAudioClip + oAudio.lengthAudioClip;
+		if (stats != nullptr) {
 
-		audio.numSamples = audio.numSamples + oAudio.numSamples;
+			for (size_t c = 0; c < N; ++c) {
 
-		return audio;
+				rms[c] = stats->rms(c);
 
-	}
+			}
 
-	/*A * F: volume factor A with F; F will be a std::pair<float,float> with each float
-	value in range [0.0,1.0]*/
-	Audio operator *(pair<float, float> vol) {
+			return rms;
 
-		Audio audio(*this);
+		}
 
-		transform(this->vectSamples.begin(), this->vectSamples.end(),
-				audio.vectSamples.begin(), [vol](pair<BitCount,BitCount> b) {
+		array<int64_t, N> zero;
 
-					return make_pair(b.first*vol.first, b.second*vol.second);
+		zero.fill(0);
 
-				});
+		const Sample* samples = vectSamples.data();
 
-		return audio;
+		array<int64_t, N> total = reduceBlocks(numSamples, zero,
+				[samples, zero](long begin, long end) {
 
-	}
+					array<int64_t, N> part = zero;
 
-	// A+B: add sound file amplitudes together (per sample)
-	Audio operator +(const Audio& oAudio) {
+					for (long k = begin; k < end; ++k) {
 
-		Audio audio(*this);
+						forEachChannel<N>([&](size_t c) {
 
-		for (int k = 0; k < vectSamples.size(); ++k) {
+							int32_t v = channelSample(samples[k], c);
 
-			BitCount totalLeft = vectSamples[k].first
-					+ oAudio.vectSamples[k].first;
+							part[c] += v * v;
 
-			if (totalLeft > numeric_limits < BitCount >::max()) {
+						});
 
-				totalLeft = numeric_limits < BitCount >::max();
+					}
 
-			}
+					return part;
 
-			BitCount totalRight = vectSamples[k].second
-					+ oAudio.vectSamples[k].second;
+				}, [](array<int64_t, N> a, const array<int64_t, N>& b) {
 
-			if (totalRight > numeric_limits < BitCount >::max()) {
+					forEachChannel<N>([&](size_t c) {
 
-				totalRight = numeric_limits < BitCount >::max();
+						a[c] += b[c];
 
-			}
+					});
+
+					return a;
+
+				});
 
-			audio.vectSamples[k].first = totalLeft;
+		for (size_t c = 0; c < N; ++c) {
+
+			rms[c] = numSamples > 0 ?
+					(float) sqrt(total[c] / (double) numSamples) : 0.0f;
 
-			audio.vectSamples[k].second = totalRight;
 		}
 
-		return audio;
+		return rms;
 
 	}
 
-	/*A^F: F will be a std::pair<int,int> which specifies start and end sample of range
-	of samples to be cut from sound file A. This implements a cut operation which
-	produces a shorter clip (A with a portion removed).*/
-	Audio operator ^(pair<int, int> range) {
+	// FORMAT CONVERSION
 
-		int numSamplesCut = numSamples - (range.second - range.first) - 1;
+	/*Convert bit depth: widen or narrow every sample to T, with optional TPDF
+	dither (independent per channel) when narrowing.*/
+	template<typename T> Audio<typename FrameTraits<Sample>::template Rebind<T>> convertBitCount(
+			bool dither) const {
 
-		int newLength = (int) (numSamplesCut / ((float) samplingRate));
+		typedef typename FrameTraits<Sample>::template Rebind<T> Converted;
 
-		vector<pair<BitCount, BitCount>> b;
+		ScopedStage stage("convertBitCount", numSamples * sizeof(Sample),
+				numSamples);
 
-		for (int k = 0; k < vectSamples.size(); ++k) {
+		long n = vectSamples.size();
 
-			if (k < range.first || k > range.second) {
+		vector<Converted> b(n);
 
-				b.push_back(vectSamples[k]);
+		const Sample* in = vectSamples.data();
 
-			}
+		Converted* out = b.data();
 
-		}
+		for (long k = 0; k < n; ++k) {
 
-		Audio<pair<BitCount, BitCount>> audio(numSamplesCut, newLength, b,
-				numChannels, samplingRate);
+			forEachChannel<N>([&](size_t c) {
 
-		return audio;
+				channelSample(out[k], c) = convertSample<T>(channelSample(in[k], c),
+						(uint32_t) (k * N + c), dither);
+
+			});
+
+		}
+
+		return Audio<Converted>((int) n, lengthAudioClip, move(b), numChannels,
+				samplingRate);
 
 	}
 
-	// AUDIO TRANSFORMATION
+};
 
-	/*Reverse: reverse all samples (this can be done very quickly with the
-	STL)*/
-	void revOrdering() {
+// 1-channel (mono) Audio class
+/*The Audio class should be templated to handle audio signals which use different
+bit sizes for samples, depending on the provided audio clips. The operations
+are those of BasicAudio; mono adds its single per-channel values as floats.*/
+template<typename BitCount> class Audio: public BasicAudio<BitCount> {
 
-		reverse(vectSamples.begin(), vectSamples.end());
+public:
+
+	using BasicAudio<BitCount>::BasicAudio;
+
+	using BasicAudio<BitCount>::operator=;
+
+	using BasicAudio<BitCount>::normalizeSound;
+
+	using BasicAudio<BitCount>::shifted;
+
+	/*Sound normalization: normalize the sound file to the specified desired rms
+	value.*/
+	Audio& normalizeSound(float RMSVal) {
+
+		return normalizeSound(array<float, 1> { { RMSVal } });
 
 	}
 
-	/*Sound normalization: Use std::transform with a custom functor to
-	normalize the sound files to the specified desired rms value (per channel).*/
-	Audio& normalizeSound(pair<float, float> RMSVal) {
+	// against a known current rms value
+	Audio& normalizeSound(float RMSVal, float rms) {
 
-		pair<float, float> rms = computeRMS();
+		return normalizeSound(array<float, 1> { { RMSVal } },
+				array<float, 1> { { rms } });
 
-		transform(vectSamples.begin(), vectSamples.end(), vectSamples.begin(),
-				Normalize(RMSVal, rms));
+	}
 
-		return *this;
+	// Shift: a copy delayed by `lag` samples (advanced when negative)
+	Audio shifted(long lag, int length) const {
+
+		return shifted(array<long, 1> { { lag } }, length);
 
 	}
 
-	/*Ranged add: select two (same length) sample ranges from two signals
-	and add them together. This differs from the overloaded + which adds
-	entire audio clips together.*/
-	Audio rangedAdd(const Audio& oAudio, pair<int, int> r) {
+	// Compute RMS
+	float computeRMS() const {
+
+		return this->channelRMS()[0];
 
-		Audio audio(*this);
+	}
+
+	/*Upmix: mono to stereo with the same signal on both channels.*/
+	Audio<pair<BitCount, BitCount>> upmix() const {
 
-		Audio audioExtractFirst(*this);
+		ScopedStage stage("upmix", this->numSamples * sizeof(BitCount),
+				this->numSamples);
 
-		audioExtractFirst.vectSamples.clear();
+		long n = this->vectSamples.size();
 
-		audioExtractFirst.vectSamples.resize(r.second - r.first);
+		vector<pair<BitCount, BitCount>> b(n);
 
-		copy(vectSamples.begin() + r.first, vectSamples.begin() + r.second,
-				audioExtractFirst.vectSamples.begin());
+		const BitCount* in = this->vectSamples.data();
 
-		Audio audioExtractSecond(oAudio);
+		pair<BitCount, BitCount>* out = b.data();
 
-		audioExtractSecond.vectSamples.clear();
+		for (long k = 0; k < n; ++k) {
 
-		audioExtractSecond.vectSamples.resize(r.second - r.first);
+			out[k].first = in[k];
 
-		copy(oAudio.vectSamples.begin() + r.first,
-				oAudio.vectSamples.begin() + r.second,
-				audioExtractSecond.vectSamples.begin());
+			out[k].second = in[k];
 
-		Audio total = audioExtractFirst + audioExtractSecond;
+		}
 
-		copy(total.vectSamples.begin(), total.vectSamples.end(),
-				audio.vectSamples.begin() + r.first);
+		int nChannels = 2;
 
-		return audio;
+		return Audio<pair<BitCount, BitCount>>((int) n, this->lengthAudioClip,
+				move(b), nChannels, this->samplingRate);
 
 	}
 
-	/*Compute RMS: use std::accumulate in <numeric> along with a custom
-	lambda to compute the RMS (per channel)*/
-	pair<float, float> computeRMS() {
+};
 
-		pair<float, float> val = { 0.0, 0.0 };
+// 2-channel (stereo) Audio class
+/*The operations are those of BasicAudio; stereo adds its per-channel values
+as (left, right) pairs.*/
+template<typename BitCount> class Audio<pair<BitCount, BitCount>> : public BasicAudio<
+		pair<BitCount, BitCount>> {
 
-		pair<float, float> totalSum = accumulate(vectSamples.begin(),
-				vectSamples.end(), val,
-				[](pair<float,float> total, pair<BitCount,BitCount> b) {
+public:
 
-					total.first = total.first + pow(b.first,2);
+	using BasicAudio<pair<BitCount, BitCount>>::BasicAudio;
 
-					total.second = total.second + pow(b.second,2);
+	using BasicAudio<pair<BitCount, BitCount>>::operator=;
 
-					return total;
+	using BasicAudio<pair<BitCount, BitCount>>::normalizeSound;
 
-				});
+	using BasicAudio<pair<BitCount, BitCount>>::crossfade;
 
-		totalSum.first = (float) sqrt(totalSum.first / ((float) numSamples));
+	using BasicAudio<pair<BitCount, BitCount>>::shifted;
 
-		totalSum.second = (float) sqrt(totalSum.second / ((float) numSamples));
+	/*Sound normalization: normalize each channel to the specified desired rms
+	value.*/
+	Audio& normalizeSound(pair<float, float> RMSVal) {
 
-		return totalSum;
+		return normalizeSound(array<float, 2> { { RMSVal.first, RMSVal.second } });
 
 	}
 
-	// Normalize class
-	class Normalize {
+	// against known current rms values
+	Audio& normalizeSound(pair<float, float> RMSVal, pair<float, float> rms) {
 
-	private:
+		return normalizeSound(array<float, 2> { { RMSVal.first, RMSVal.second } },
+				array<float, 2> { { rms.first, rms.second } });
 
-		pair<float, float> newValue, value;
+	}
 
-	public:
+	// Crossfade with a fade length for each channel
+	Audio crossfade(const Audio& oAudio, pair<int, int> overlap) const {
 
-		// CONSTRUCTOR
-		Normalize(pair<float, float> d, pair<float, float> c) :
-				newValue(d), value(c) {
+		return crossfade(oAudio,
+				array<int, 2> { { overlap.first, overlap.second } });
 
-		}
+	}
 
-		// OPERATOR
-		pair<BitCount, BitCount> operator()(pair<BitCount, BitCount> b) {
+	// Shift: left channel delayed by lag.first samples and right by lag.second
+	Audio shifted(pair<long, long> lag, int length) const {
 
-			BitCount bLeft = (BitCount) (b.first
-					* (newValue.first / value.first));
+		return shifted(array<long, 2> { { lag.first, lag.second } }, length);
 
-			BitCount bRight = (BitCount) (b.second
-					* (newValue.second / value.second));
+	}
 
-			if (bLeft > numeric_limits < BitCount >::max()) {
+	// Compute RMS (per channel)
+	pair<float, float> computeRMS() const {
 
-				bLeft = numeric_limits < BitCount >::max();
+		array<float, 2> rms = this->channelRMS();
 
-			}
+		return make_pair(rms[0], rms[1]);
 
-			if (bRight > numeric_limits < BitCount >::max()) {
+	}
 
-				bRight = numeric_limits < BitCount >::max();
+	/*Downmix: stereo to mono as gains.first * left + gains.second * right.*/
+	Audio<BitCount> downmix(pair<float, float> gains) const {
 
-			}
+		ScopedStage stage("downmix", this->numSamples * sizeof(BitCount) * 2,
+				this->numSamples);
+
+		long n = this->vectSamples.size();
+
+		vector<BitCount> b(n);
+
+		const pair<BitCount, BitCount>* in = this->vectSamples.data();
+
+		BitCount* out = b.data();
+
+		for (long k = 0; k < n; ++k) {
 
-			return {bLeft, bRight};
+			out[k] = saturate<BitCount>(
+					in[k].first * gains.first + in[k].second * gains.second);
 
 		}
 
-	};
+		int nChannels = 1;
+
+		return Audio<BitCount>((int) n, this->lengthAudioClip, move(b), nChannels,
+				this->samplingRate);
+
+	}
+
+};
+
+// N-channel Audio class
+/*Audio<Frame<BitCount, N>> holds frames of N samples (N = 4, 6 or 8 for quad,
+5.1 and 7.1 stems); its operations are those of BasicAudio.*/
+template<typename BitCount, size_t N> class Audio<Frame<BitCount, N>> : public BasicAudio<
+		Frame<BitCount, N>> {
+
+public:
+
+	using BasicAudio<Frame<BitCount, N>>::BasicAudio;
+
+	using BasicAudio<Frame<BitCount, N>>::operator=;
+
+	// Compute RMS (per channel)
+	array<float, N> computeRMS() const {
+
+		return this->channelRMS();
+
+	}
 
 };
 
@@ -0,0 +1,252 @@
+//=================================================================================
+// Name        : Benchmark.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Micro-benchmarks behind the figures quoted in the README (make
+// 				 bench): each one times an operation against its naive baseline
+//=================================================================================
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Convolution.h"
+#include "Reduce.h"
+
+using namespace std;
+using namespace DPLKYL002;
+
+// best wall time (ms) of a few runs of fn
+template<typename Function> double bestTimeMs(Function fn, int runs = 3) {
+
+	double best = 0;
+
+	for (int k = 0; k < runs; ++k) {
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+		fn();
+
+		double ms = chrono::duration<double, milli>(
+				chrono::steady_clock::now() - start).count();
+
+		best = (k == 0 || ms < best) ? ms : best;
+
+	}
+
+	return best;
+
+}
+
+// reproducible pseudo-random samples in [-1, 1)
+vector<float> noise(long n, unsigned seed) {
+
+	vector<float> x(n);
+
+	srand(seed);
+
+	for (long k = 0; k < n; ++k) {
+
+		x[k] = 2.0f * rand() / (RAND_MAX + 1.0f) - 1.0f;
+
+	}
+
+	return x;
+
+}
+
+/*-conv: directConvolve against fftConvolve on 2 s of 44.1 kHz noise for impulse
+responses from 16 to 16384 taps, with the largest difference between the two
+results (relative to the peak of the direct one).*/
+void benchConvolution() {
+
+	vector<float> x = noise(2 * 44100, 1);
+
+	cout << "Convolution: " << x.size() << " samples" << endl;
+
+	cout << setw(8) << "taps" << setw(14) << "direct ms" << setw(14) << "fft ms"
+			<< setw(12) << "speedup" << setw(14) << "rel. error" << endl;
+
+	for (long taps = 16; taps <= 16384; taps *= 4) {
+
+		vector<float> h = noise(taps, 2);
+
+		vector<float> direct, fast;
+
+		double directMs = bestTimeMs([&]() {
+
+			direct = directConvolve(x, h);
+
+		}, taps >= 4096 ? 1 : 3);
+
+		// (below DIRECT_CONVOLUTION_TAPS fftConvolve convolves directly as well)
+		double fftMs = bestTimeMs([&]() {
+
+			fast = fftConvolve(x, h);
+
+		});
+
+		double peak = 0, error = 0;
+
+		for (long k = 0; k < direct.size(); ++k) {
+
+			peak = max(peak, (double) fabs(direct[k]));
+
+			error = max(error, (double) fabs(direct[k] - fast[k]));
+
+		}
+
+		cout << setw(8) << taps << setw(14) << fixed << setprecision(1) << directMs
+				<< setw(14) << fftMs << setw(12) << setprecision(1)
+				<< directMs / fftMs << setw(14) << scientific << setprecision(2)
+				<< error / peak << endl;
+
+		cout.unsetf(ios::floatfield);
+
+	}
+
+}
+
+/*-rms / -norm: the per-channel sum of squares of 190 MB of 16-bit stereo noise,
+summed exactly as 64-bit integers by reduceBlocks (as Audio::channelRMS does)
+against a naive float sum with one accumulator per channel and thread, with the
+error of each rms relative to the exact one.*/
+void benchReduce() {
+
+	const long frames = 190L * (1 << 20) / 4;
+
+	vector<int16_t> x(2 * frames);
+
+	uint32_t state = 1;
+
+	for (long k = 0; k < (long) x.size(); ++k) {
+
+		state = state * 1664525u + 1013904223u;
+
+		x[k] = (int16_t) (state >> 16);
+
+	}
+
+	const int16_t* samples = x.data();
+
+	typedef array<int64_t, 2> Sums;
+
+	Sums exact = { { 0, 0 } };
+
+	double exactMs = bestTimeMs([&]() {
+
+		Sums zero = { { 0, 0 } };
+
+		exact = reduceBlocks(frames, zero, [samples](long begin, long end) {
+
+			int64_t left = 0, right = 0;
+
+			for (long k = begin; k < end; ++k) {
+
+				int32_t l = samples[2 * k], r = samples[2 * k + 1];
+
+				left += l * l;
+
+				right += r * r;
+
+			}
+
+			Sums part = { { left, right } };
+
+			return part;
+
+		}, [](const Sums& a, const Sums& b) {
+
+			Sums sum = { { a[0] + b[0], a[1] + b[1] } };
+
+			return sum;
+
+		});
+
+	});
+
+	float naive[2] = { 0.0f, 0.0f };
+
+	double naiveMs = bestTimeMs([&]() {
+
+		mutex lock;
+
+		naive[0] = naive[1] = 0.0f;
+
+		parallelFor(frames, [&](long begin, long end) {
+
+			float left = 0.0f, right = 0.0f;
+
+			for (long k = begin; k < end; ++k) {
+
+				float l = samples[2 * k], r = samples[2 * k + 1];
+
+				left += l * l;
+
+				right += r * r;
+
+			}
+
+			lock_guard<mutex> guard(lock);
+
+			naive[0] += left;
+
+			naive[1] += right;
+
+		});
+
+	});
+
+	cout << "Sum of squares: " << frames << " stereo frames ("
+			<< x.size() * sizeof(int16_t) / (1 << 20) << " MB), "
+			<< numWorkerThreads() << " threads" << endl;
+
+	cout << setw(24) << "method" << setw(12) << "ms" << setw(16) << "rms error"
+			<< endl;
+
+	double worst = 0;
+
+	for (int c = 0; c < 2; ++c) {
+
+		double rms = sqrt(exact[c] / (double) frames);
+
+		worst = max(worst, fabs(sqrt(naive[c] / (double) frames) - rms) / rms);
+
+	}
+
+	cout << setw(24) << "reduceBlocks (int64)" << setw(12) << fixed
+			<< setprecision(1) << exactMs << setw(16) << "exact" << endl;
+
+	cout << setw(24) << "naive float per thread" << setw(12) << naiveMs
+			<< setw(15) << setprecision(1) << 100 * worst << "%" << endl;
+
+	cout.unsetf(ios::floatfield);
+
+}
+
+// usage: samp_bench [conv | reduce]
+int main(int argc, char* argv[]) {
+
+	string which = argc > 1 ? argv[1] : "all";
+
+	if (which == "all" || which == "conv") {
+
+		benchConvolution();
+
+	}
+
+	if (which == "all" || which == "reduce") {
+
+		benchReduce();
+
+	}
+
+	return 0;
+
+}
@@ -0,0 +1,450 @@
+//=================================================================================
+// Name        : Biquad.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Cascaded biquad IIR filters (EQ, high-pass / DC removal, low-pass)
+// 				 with state carried across blocks
+//=================================================================================
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef LIBS_BIQUAD_H
+#define LIBS_BIQUAD_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// samples per group of the block-state feedback recursion (mono)
+const int FEEDBACK_LANES = 8;
+
+// Biquad struct
+/*One second-order section, normalized so a0 = 1:
+	y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+Coefficients follow the RBJ audio EQ cookbook.*/
+struct Biquad {
+
+	float b0, b1, b2, a1, a2;
+
+	static Biquad fromRaw(double b0, double b1, double b2, double a0, double a1,
+			double a2) {
+
+		Biquad q = { (float) (b0 / a0), (float) (b1 / a0), (float) (b2 / a0),
+				(float) (a1 / a0), (float) (a2 / a0) };
+
+		return q;
+
+	}
+
+	static Biquad lowPass(int rate, double freq, double q) {
+
+		double w = 2 * M_PI * freq / rate, alpha = sin(w) / (2 * q), c = cos(w);
+
+		return fromRaw((1 - c) / 2, 1 - c, (1 - c) / 2, 1 + alpha, -2 * c,
+				1 - alpha);
+
+	}
+
+	static Biquad highPass(int rate, double freq, double q) {
+
+		double w = 2 * M_PI * freq / rate, alpha = sin(w) / (2 * q), c = cos(w);
+
+		return fromRaw((1 + c) / 2, -(1 + c), (1 + c) / 2, 1 + alpha, -2 * c,
+				1 - alpha);
+
+	}
+
+	static Biquad peaking(int rate, double freq, double q, double gainDb) {
+
+		double w = 2 * M_PI * freq / rate, alpha = sin(w) / (2 * q), c = cos(w);
+
+		double a = pow(10.0, gainDb / 40);
+
+		return fromRaw(1 + alpha * a, -2 * c, 1 - alpha * a, 1 + alpha / a,
+				-2 * c, 1 - alpha / a);
+
+	}
+
+	static Biquad lowShelf(int rate, double freq, double q, double gainDb) {
+
+		double w = 2 * M_PI * freq / rate, alpha = sin(w) / (2 * q), c = cos(w);
+
+		double a = pow(10.0, gainDb / 40), s = 2 * sqrt(a) * alpha;
+
+		return fromRaw(a * ((a + 1) - (a - 1) * c + s),
+				2 * a * ((a - 1) - (a + 1) * c), a * ((a + 1) - (a - 1) * c - s),
+				(a + 1) + (a - 1) * c + s, -2 * ((a - 1) + (a + 1) * c),
+				(a + 1) + (a - 1) * c - s);
+
+	}
+
+	static Biquad highShelf(int rate, double freq, double q, double gainDb) {
+
+		double w = 2 * M_PI * freq / rate, alpha = sin(w) / (2 * q), c = cos(w);
+
+		double a = pow(10.0, gainDb / 40), s = 2 * sqrt(a) * alpha;
+
+		return fromRaw(a * ((a + 1) + (a - 1) * c + s),
+				-2 * a * ((a - 1) + (a + 1) * c), a * ((a + 1) + (a - 1) * c - s),
+				(a + 1) - (a - 1) * c + s, 2 * ((a - 1) - (a + 1) * c),
+				(a + 1) - (a - 1) * c - s);
+
+	}
+
+};
+
+// BiquadChain class
+/*A cascade of biquad sections plus the per-channel filter state (last two inputs
+and outputs of every section), so a long signal can be filtered block by block.
+
+Each block is filtered section by section in two passes: the feed-forward part
+w = b0 x[n] + b1 x[n-1] + b2 x[n-2] has no dependence between samples and is a
+plain vectorizable loop. The samples only depend on each other through the
+feedback recursion y[n] = w[n] - a1 y[n-1] - a2 y[n-2]. Stereo runs it for both
+channels in the same loop, one channel per lane. Mono (and each channel of the
+generic N-channel clips) uses the block-state form instead: within a group of
+FEEDBACK_LANES samples
+	y[n+i] = sum_{j<=i} h[j] w[n+i-j] + h[i+1] y[n-1] - a2 h[i] y[n-2]
+with h the impulse response of the feedback part, so the group is a small
+matrix-vector product over lanes and only the last two outputs of each group
+carry over to the next.*/
+class BiquadChain {
+
+private:
+
+	vector<Biquad> sections;
+
+	int numChannels;
+
+	// x1, x2, y1, y2 per section per channel
+	vector<float> state;
+
+	vector<float> work;
+
+	float* stateOf(int section, int channel) {
+
+		return &state[(section * numChannels + channel) * 4];
+
+	}
+
+	// feed-forward pass over a block (in place), updating the input history
+	void feedForward(const Biquad& q, float* x, int n, float* s) {
+
+		if (n == 0) {
+
+			return;
+
+		}
+
+		work.resize(n + 2);
+
+		work[0] = s[1];
+
+		work[1] = s[0];
+
+		copy(x, x + n, work.begin() + 2);
+
+		const float* w = work.data() + 2;
+
+		for (int k = 0; k < n; ++k) {
+
+			x[k] = q.b0 * w[k] + q.b1 * w[k - 1] + q.b2 * w[k - 2];
+
+		}
+
+		s[1] = n > 1 ? w[n - 2] : s[0];
+
+		s[0] = w[n - 1];
+
+	}
+
+	/*Feedback pass over a block (in place) in block-state form: groups of
+	FEEDBACK_LANES samples are computed from their feed-forward values and the
+	last two outputs of the previous group (see the class comment); the few
+	samples after the last whole group run the plain recursion. The lanes are
+	doubles: with poles near z = 1 (dc, low shelves) h grows across the group
+	and float lanes would lose more to cancellation than the serial recursion.*/
+	void feedBack(const Biquad& q, float* x, int n, float* s) {
+
+		const int L = FEEDBACK_LANES;
+
+		// h[0 .. L]: impulse response of 1 / (1 + a1 z^-1 + a2 z^-2)
+		double h[L + 1];
+
+		h[0] = 1.0;
+
+		h[1] = -q.a1;
+
+		for (int i = 2; i <= L; ++i) {
+
+			h[i] = -q.a1 * h[i - 1] - q.a2 * h[i - 2];
+
+		}
+
+		// m[j][i] = h[i - j]: contribution of w[j] to y[i] within a group
+		double m[L][L], c1[L], c2[L];
+
+		for (int j = 0; j < L; ++j) {
+
+			for (int i = 0; i < L; ++i) {
+
+				m[j][i] = i >= j ? h[i - j] : 0.0;
+
+			}
+
+			c1[j] = h[j + 1];
+
+			c2[j] = -q.a2 * h[j];
+
+		}
+
+		double y1 = s[2], y2 = s[3];
+
+		int k = 0;
+
+		for (; k + L <= n; k += L) {
+
+			double y[L];
+
+			for (int i = 0; i < L; ++i) {
+
+				y[i] = c1[i] * y1 + c2[i] * y2;
+
+			}
+
+			for (int j = 0; j < L; ++j) {
+
+				for (int i = 0; i < L; ++i) {
+
+					y[i] += m[j][i] * x[k + j];
+
+				}
+
+			}
+
+			for (int i = 0; i < L; ++i) {
+
+				x[k + i] = (float) y[i];
+
+			}
+
+			y1 = y[L - 1];
+
+			y2 = y[L - 2];
+
+		}
+
+		for (; k < n; ++k) {
+
+			double y = x[k] - q.a1 * y1 - q.a2 * y2;
+
+			y2 = y1;
+
+			y1 = y;
+
+			x[k] = (float) y;
+
+		}
+
+		s[2] = (float) y1;
+
+		s[3] = (float) y2;
+
+	}
+
+public:
+
+	// CONSTRUCTOR
+	BiquadChain(const vector<Biquad>& s, int nChannels) :
+			sections(s), numChannels(nChannels), state(
+					s.size() * nChannels * 4, 0.0f) {
+
+	}
+
+	// filter one channel block in place
+	void process(float* x, int n, int channel = 0) {
+
+		for (int j = 0; j < sections.size(); ++j) {
+
+			const Biquad& q = sections[j];
+
+			float* s = stateOf(j, channel);
+
+			feedForward(q, x, n, s);
+
+			feedBack(q, x, n, s);
+
+		}
+
+	}
+
+	// filter a left/right block pair in place (both channels in one recursion)
+	void processStereo(float* left, float* right, int n) {
+
+		for (int j = 0; j < sections.size(); ++j) {
+
+			const Biquad& q = sections[j];
+
+			float* sLeft = stateOf(j, 0);
+
+			float* sRight = stateOf(j, 1);
+
+			feedForward(q, left, n, sLeft);
+
+			feedForward(q, right, n, sRight);
+
+			float y1[2] = { sLeft[2], sRight[2] }, y2[2] = { sLeft[3], sRight[3] };
+
+			for (int k = 0; k < n; ++k) {
+
+				float in[2] = { left[k], right[k] }, y[2];
+
+				for (int c = 0; c < 2; ++c) {
+
+					y[c] = in[c] - q.a1 * y1[c] - q.a2 * y2[c];
+
+					y2[c] = y1[c];
+
+					y1[c] = y[c];
+
+				}
+
+				left[k] = y[0];
+
+				right[k] = y[1];
+
+			}
+
+			sLeft[2] = y1[0];
+			sLeft[3] = y2[0];
+
+			sRight[2] = y1[1];
+			sRight[3] = y2[1];
+
+		}
+
+	}
+
+	// filter state (x1, x2, y1, y2 per section per channel), to resume a signal later
+	const vector<float>& getState() const {
+
+		return state;
+
+	}
+
+	void setState(const vector<float>& s) {
+
+		if (s.size() == state.size()) {
+
+			state = s;
+
+		}
+
+	}
+
+	/*Parse a filter specification: comma separated sections type:freq[:q[:gainDb]]
+	with type one of lp, hp, peak, ls (low shelf), hs (high shelf) and dc
+	(DC removal, a 10 Hz high-pass). Q defaults to 0.7071, gain to 0 dB.
+	Returns false (with the reason in error) for an invalid specification.*/
+	static bool tryParse(const string& spec, int rate, int nChannels,
+			BiquadChain& chain, string& error) {
+
+		vector<Biquad> s;
+
+		stringstream ss(spec);
+
+		string section;
+
+		while (getline(ss, section, ',')) {
+
+			stringstream fields(section);
+
+			string type, value;
+
+			getline(fields, type, ':');
+
+			vector<double> v;
+
+			while (getline(fields, value, ':')) {
+
+				v.push_back(atof(value.c_str()));
+
+			}
+
+			double freq = v.size() > 0 ? v[0] : 10.0;
+
+			double q = v.size() > 1 ? v[1] : 0.7071;
+
+			double gainDb = v.size() > 2 ? v[2] : 0.0;
+
+			if (freq <= 0 || freq >= rate / 2.0 || q <= 0) {
+
+				error = "invalid filter section [" + section + "]";
+
+				return false;
+
+			} else if (type == "lp") {
+
+				s.push_back(Biquad::lowPass(rate, freq, q));
+
+			} else if (type == "hp" || type == "dc") {
+
+				s.push_back(Biquad::highPass(rate, freq, q));
+
+			} else if (type == "peak") {
+
+				s.push_back(Biquad::peaking(rate, freq, q, gainDb));
+
+			} else if (type == "ls") {
+
+				s.push_back(Biquad::lowShelf(rate, freq, q, gainDb));
+
+			} else if (type == "hs") {
+
+				s.push_back(Biquad::highShelf(rate, freq, q, gainDb));
+
+			} else {
+
+				error = "unknown filter type [" + type + "]";
+
+				return false;
+
+			}
+
+		}
+
+		chain = BiquadChain(s, nChannels);
+
+		return true;
+
+	}
+
+	// parse a filter specification (see tryParse), exiting if it is invalid
+	static BiquadChain parse(const string& spec, int rate, int nChannels) {
+
+		BiquadChain chain(vector<Biquad>(), nChannels);
+
+		string error;
+
+		if (!tryParse(spec, rate, nChannels, chain, error)) {
+
+			cout << "Error: " << error << "." << endl;
+
+			exit(1);
+
+		}
+
+		return chain;
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,761 @@
+//=================================================================================
+// Name        : Cache.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Content-addressed result cache (--cache): a job already run on the
+// 				 same input contents is answered by cloning the stored outputs
+//=================================================================================
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include "Split.h"
+
+#ifndef LIBS_CACHE_H
+#define LIBS_CACHE_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// ContentHash class
+/*Streaming 64-bit xxHash (XXH64): four independent multiply-rotate lanes over
+32-byte stripes, so hashing runs at memory speed. Output matches the reference
+XXH64 for the same bytes and seed.*/
+class ContentHash {
+
+private:
+
+	static const uint64_t P1 = 11400714785074694791ULL;
+	static const uint64_t P2 = 14029467366897019727ULL;
+	static const uint64_t P3 = 1609587929392839161ULL;
+	static const uint64_t P4 = 9650029242287828579ULL;
+	static const uint64_t P5 = 2870177450012600261ULL;
+
+	uint64_t seed, total, lanes[4];
+
+	unsigned char buffer[32];
+
+	size_t buffered;
+
+	static uint64_t rotl(uint64_t x, int r) {
+
+		return (x << r) | (x >> (64 - r));
+
+	}
+
+	static uint64_t read64(const unsigned char* p) {
+
+		uint64_t v;
+
+		memcpy(&v, p, sizeof(v));
+
+		return v;
+
+	}
+
+	static uint64_t round(uint64_t acc, uint64_t input) {
+
+		return rotl(acc + input * P2, 31) * P1;
+
+	}
+
+	static uint64_t merge(uint64_t acc, uint64_t lane) {
+
+		return (acc ^ round(0, lane)) * P1 + P4;
+
+	}
+
+	void stripe(const unsigned char* p) {
+
+		for (int k = 0; k < 4; ++k) {
+
+			lanes[k] = round(lanes[k], read64(p + 8 * k));
+
+		}
+
+	}
+
+public:
+
+	// CONSTRUCTOR
+	ContentHash(uint64_t s = 0) :
+			seed(s), total(0), buffered(0) {
+
+		lanes[0] = seed + P1 + P2;
+
+		lanes[1] = seed + P2;
+
+		lanes[2] = seed;
+
+		lanes[3] = seed - P1;
+
+	}
+
+	void update(const void* data, size_t n) {
+
+		const unsigned char* p = (const unsigned char*) data;
+
+		total += n;
+
+		if (buffered + n < 32) {
+
+			memcpy(buffer + buffered, p, n);
+
+			buffered += n;
+
+			return;
+
+		}
+
+		if (buffered > 0) {
+
+			size_t fill = 32 - buffered;
+
+			memcpy(buffer + buffered, p, fill);
+
+			stripe(buffer);
+
+			p += fill;
+
+			n -= fill;
+
+			buffered = 0;
+
+		}
+
+		for (; n >= 32; p += 32, n -= 32) {
+
+			stripe(p);
+
+		}
+
+		memcpy(buffer, p, n);
+
+		buffered = n;
+
+	}
+
+	// a length-prefixed string, so consecutive fields cannot run together
+	void update(const string& s) {
+
+		uint64_t n = s.size();
+
+		update(&n, sizeof(n));
+
+		update(s.data(), s.size());
+
+	}
+
+	// bytes hashed so far
+	uint64_t length() const {
+
+		return total;
+
+	}
+
+	uint64_t digest() const {
+
+		uint64_t h;
+
+		if (total >= 32) {
+
+			h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12)
+					+ rotl(lanes[3], 18);
+
+			for (int k = 0; k < 4; ++k) {
+
+				h = merge(h, lanes[k]);
+
+			}
+
+		} else {
+
+			h = seed + P5;
+
+		}
+
+		h += total;
+
+		const unsigned char* p = buffer;
+
+		size_t n = buffered;
+
+		for (; n >= 8; p += 8, n -= 8) {
+
+			h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+
+		}
+
+		if (n >= 4) {
+
+			uint32_t v;
+
+			memcpy(&v, p, sizeof(v));
+
+			h = rotl(h ^ (v * P1), 23) * P2 + P3;
+
+			p += 4;
+
+			n -= 4;
+
+		}
+
+		for (; n > 0; ++p, --n) {
+
+			h = rotl(h ^ (*p * P5), 11) * P1;
+
+		}
+
+		h ^= h >> 33;
+
+		h *= P2;
+
+		h ^= h >> 29;
+
+		h *= P3;
+
+		h ^= h >> 32;
+
+		return h;
+
+	}
+
+};
+
+// hash the contents of a regular file (false if it is not one or cannot be read)
+inline bool hashFile(const string& fileName, ContentHash& hash) {
+
+	struct stat info;
+
+	if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+
+		return false;
+
+	}
+
+	int fd = open(fileName.c_str(), O_RDONLY);
+
+	if (fd < 0) {
+
+		return false;
+
+	}
+
+	vector<char> chunk(1 << 20);
+
+	ssize_t n;
+
+	while ((n = read(fd, chunk.data(), chunk.size())) > 0) {
+
+		hash.update(chunk.data(), n);
+
+	}
+
+	close(fd);
+
+	return n == 0;
+
+}
+
+// TeeBuffer class
+/*Stream buffer that writes to two others: while a job runs, cout goes to the
+console and into the transcript that is stored with the job's outputs.*/
+class TeeBuffer: public streambuf {
+
+private:
+
+	streambuf *first, *second;
+
+protected:
+
+	int overflow(int c) {
+
+		if (c != EOF) {
+
+			first->sputc((char) c);
+
+			second->sputc((char) c);
+
+		}
+
+		return c;
+
+	}
+
+	streamsize xsputn(const char* s, streamsize n) {
+
+		first->sputn(s, n);
+
+		return second->sputn(s, n);
+
+	}
+
+	int sync() {
+
+		return first->pubsync();
+
+	}
+
+public:
+
+	// CONSTRUCTOR
+	TeeBuffer(streambuf* a, streambuf* b) :
+			first(a), second(b) {
+
+	}
+
+};
+
+// ResultCache class
+/*On-disk cache of job results, one directory per job key under the cache
+directory. The key is an XXH64 of the sample format, the --slac flag, the
+operation and its arguments (every argument naming a file contributes that
+file's content hash instead of its name) and the samp binary itself, so
+renamed or re-downloaded inputs still hit and a rebuilt program never does.
+The output name (-o) is not part of the key: outputs are stored by their suffix
+after the output name and recreated under whatever name the new job asks for.
+
+An entry holds the output files, their suffixes and hashes ("files") and the
+console transcript ("stdout"). A hit verifies each stored file against its
+hash, then recreates it as a reflink (shared extents, on filesystems that
+support it), else a copy; no Audio is loaded. Entries are evicted least
+recently used first (a hit refreshes the entry's time) once the cache exceeds
+its size limit.*/
+class ResultCache {
+
+private:
+
+	string directory;
+
+	long limitBytes;
+
+	stringstream transcript;
+
+	streambuf* console;
+
+	TeeBuffer* tee;
+
+	static string hex(uint64_t h) {
+
+		char text[17];
+
+		snprintf(text, sizeof(text), "%016llx", (unsigned long long) h);
+
+		return text;
+
+	}
+
+	static vector<string> listDirectory(const string& path) {
+
+		vector<string> names;
+
+		DIR* dir = opendir(path.c_str());
+
+		if (dir == NULL) {
+
+			return names;
+
+		}
+
+		while (struct dirent* entry = readdir(dir)) {
+
+			string name = entry->d_name;
+
+			if (name != "." && name != "..") {
+
+				names.push_back(name);
+
+			}
+
+		}
+
+		closedir(dir);
+
+		return names;
+
+	}
+
+	static void removeTree(const string& path) {
+
+		vector<string> names = listDirectory(path);
+
+		for (int k = 0; k < names.size(); ++k) {
+
+			unlink((path + "/" + names[k]).c_str());
+
+		}
+
+		rmdir(path.c_str());
+
+	}
+
+	// reflink / copy src to dst (new file); the entry side of a store
+	static bool cloneFile(const string& src, const string& dst, mode_t mode) {
+
+		int inFd = open(src.c_str(), O_RDONLY);
+
+		if (inFd < 0) {
+
+			return false;
+
+		}
+
+		int outFd = open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode);
+
+		bool ok = outFd >= 0;
+
+		if (ok && ioctl(outFd, FICLONE, inFd) != 0) {
+
+			struct stat info;
+
+			ok = fstat(inFd, &info) == 0
+					&& copyByteRange(inFd, outFd, 0, (size_t) info.st_size);
+
+		}
+
+		if (outFd >= 0) {
+
+			close(outFd);
+
+		}
+
+		close(inFd);
+
+		return ok;
+
+	}
+
+	/*recreate a stored output as a new, writable file: reflink, else copy (never
+	a hard link, which would hand the read-only entry itself to the user)*/
+	static bool materialize(const string& src, const string& dst) {
+
+		unlink(dst.c_str());
+
+		return cloneFile(src, dst, 0644);
+
+	}
+
+	static uint64_t fileHash(const string& fileName) {
+
+		ContentHash hash;
+
+		return hashFile(fileName, hash) ? hash.digest() : 0;
+
+	}
+
+	// bytes stored in an entry
+	static long entrySize(const string& path) {
+
+		vector<string> names = listDirectory(path);
+
+		long bytes = 0;
+
+		for (int k = 0; k < names.size(); ++k) {
+
+			struct stat info;
+
+			if (stat((path + "/" + names[k]).c_str(), &info) == 0) {
+
+				bytes += info.st_size;
+
+			}
+
+		}
+
+		return bytes;
+
+	}
+
+	// drop least recently used entries until the cache fits its limit
+	void evict() {
+
+		vector<pair<struct timespec, string>> entries;
+
+		vector<string> names = listDirectory(directory);
+
+		long total = 0;
+
+		for (int k = 0; k < names.size(); ++k) {
+
+			struct stat info;
+
+			string path = directory + "/" + names[k];
+
+			if (names[k][0] == '.' || stat(path.c_str(), &info) != 0
+					|| !S_ISDIR(info.st_mode)) {
+
+				continue;
+
+			}
+
+			total += entrySize(path);
+
+			entries.push_back(make_pair(info.st_mtim, path));
+
+		}
+
+		sort(entries.begin(), entries.end(),
+				[](const pair<struct timespec, string>& a,
+						const pair<struct timespec, string>& b) {
+
+					return a.first.tv_sec != b.first.tv_sec ?
+					a.first.tv_sec < b.first.tv_sec :
+					a.first.tv_nsec < b.first.tv_nsec;
+
+				});
+
+		for (int k = 0; k < entries.size() && total > limitBytes; ++k) {
+
+			total -= entrySize(entries[k].second);
+
+			removeTree(entries[k].second);
+
+		}
+
+	}
+
+public:
+
+	// CONSTRUCTOR
+	ResultCache(const string& dir, long limitMegabytes) :
+			directory(dir), limitBytes(limitMegabytes << 20), console(NULL), tee(
+					NULL) {
+
+	}
+
+	// DESTRUCTOR
+	~ResultCache() {
+
+		if (tee != NULL) {
+
+			cout.rdbuf(console);
+
+			delete tee;
+
+		}
+
+	}
+
+	/*Key of the job given by the command line: the format, the --slac flag and
+	argv[first, argc) (the operation and its arguments), with file arguments
+	replaced by their contents.*/
+	string jobKey(int samplingRate, int bitCount, int numChannels, bool slac,
+			char* argv[], int first, int argc) const {
+
+		ScopedStage stage("cacheKey");
+
+		ContentHash hash;
+
+		struct stat program;
+
+		if (stat("/proc/self/exe", &program) == 0) {
+
+			hash.update(&program.st_size, sizeof(program.st_size));
+
+			hash.update(&program.st_mtim, sizeof(program.st_mtim));
+
+		}
+
+		hash.update(to_string(samplingRate) + " " + to_string(bitCount) + " "
+				+ to_string(numChannels) + (slac ? " slac" : " raw"));
+
+		long bytes = 0;
+
+		for (int k = first; k < argc; ++k) {
+
+			ContentHash content;
+
+			if (hashFile(argv[k], content)) {
+
+				hash.update(hex(content.digest()));
+
+				bytes += content.length();
+
+			} else {
+
+				hash.update(string(argv[k]));
+
+			}
+
+		}
+
+		stage.setWork(bytes, 0);
+
+		return hex(hash.digest());
+
+	}
+
+	/*Cache hit: recreate the stored outputs under outputFileName and replay the
+	console output. False (and nothing written) on a miss or a damaged entry.*/
+	bool restore(const string& key, const string& outputFileName) {
+
+		ScopedStage stage("cacheRestore");
+
+		string entry = directory + "/" + key;
+
+		ifstream manifest(entry + "/files");
+
+		if (!manifest.is_open()) {
+
+			return false;
+
+		}
+
+		vector<pair<string, string>> files;
+
+		string line;
+
+		while (getline(manifest, line)) {
+
+			size_t space = line.find(' ');
+
+			string stored = entry + "/" + to_string(files.size());
+
+			if (space == string::npos
+					|| hex(fileHash(stored)) != line.substr(0, space)) {
+
+				// a damaged or partial entry
+				removeTree(entry);
+
+				return false;
+
+			}
+
+			files.push_back(make_pair(stored, line.substr(space + 1)));
+
+		}
+
+		for (int k = 0; k < files.size(); ++k) {
+
+			if (!materialize(files[k].first, outputFileName + files[k].second)) {
+
+				cout << "Error: unable to restore cached output." << endl;
+
+				exit(1);
+
+			}
+
+		}
+
+		ifstream replay(entry + "/stdout");
+
+		cout << replay.rdbuf();
+
+		cout.flush();
+
+		utimensat(AT_FDCWD, entry.c_str(), NULL, 0);
+
+		return true;
+
+	}
+
+	/*Cache miss: note the outputs written from here on (see writtenFiles) and
+	copy the console output into the transcript stored with the result.*/
+	void record() {
+
+		writtenFiles().clear();
+
+		console = cout.rdbuf();
+
+		tee = new TeeBuffer(console, transcript.rdbuf());
+
+		cout.rdbuf(tee);
+
+	}
+
+	/*Store the job's outputs (exactly the files it wrote since record(), each
+	named outputFileName plus a suffix) and its transcript under key, then
+	enforce the size limit. The entry is built under a temporary name and renamed
+	into place, so concurrent jobs never see half an entry.*/
+	void store(const string& key, const string& outputFileName) {
+
+		cout.flush();
+
+		cout.rdbuf(console);
+
+		delete tee;
+
+		tee = NULL;
+
+		ScopedStage stage("cacheStore");
+
+		mkdir(directory.c_str(), 0755);
+
+		string entry = directory + "/" + key;
+
+		string building = directory + "/.tmp-" + to_string(getpid()) + "-" + key;
+
+		removeTree(building);
+
+		if (mkdir(building.c_str(), 0755) != 0) {
+
+			return;
+
+		}
+
+		vector<string> names = writtenFiles();
+
+		sort(names.begin(), names.end());
+
+		names.erase(unique(names.begin(), names.end()), names.end());
+
+		ofstream manifest(building + "/files");
+
+		for (int k = 0; k < names.size(); ++k) {
+
+			string stored = building + "/" + to_string(k);
+
+			// an output that cannot be recreated from the -o name is not cached
+			if (names[k].compare(0, outputFileName.size(), outputFileName) != 0
+					|| !cloneFile(names[k], stored, 0444)) {
+
+				removeTree(building);
+
+				return;
+
+			}
+
+			manifest << hex(fileHash(stored)) << " "
+					<< names[k].substr(outputFileName.size()) << "\n";
+
+		}
+
+		manifest.close();
+
+		ofstream console(building + "/stdout");
+
+		console << transcript.str();
+
+		console.close();
+
+		if (rename(building.c_str(), entry.c_str()) != 0) {
+
+			// another job stored the same result first
+			removeTree(building);
+
+		}
+
+		evict();
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,93 @@
+//=================================================================================
+// Name        : Convert.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Sample format conversion: widening / narrowing between bit depths
+// 				 with optional TPDF dither
+//=================================================================================
+
+#include <cstdint>
+#include <limits>
+
+#ifndef LIBS_CONVERT_H
+#define LIBS_CONVERT_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// stateless 32-bit integer hash (so dither noise for sample k needs no RNG state)
+inline uint32_t hashIndex(uint32_t x) {
+
+	x ^= x >> 16;
+
+	x *= 0x7feb352dU;
+
+	x ^= x >> 15;
+
+	x *= 0x846ca68bU;
+
+	x ^= x >> 16;
+
+	return x;
+
+}
+
+/*TPDF dither for sample k when dropping `bits` low bits: the difference of two
+uniform values in [0, 2^bits), i.e. triangular noise of +/- 1 LSB of the
+narrower format. Derived from the sample index, so the conversion loop has no
+carried state and vectorizes.*/
+inline int tpdfDither(uint32_t k, int bits) {
+
+	uint32_t mask = (1U << bits) - 1;
+
+	return (int) (hashIndex(2 * k) & mask) - (int) (hashIndex(2 * k + 1) & mask);
+
+}
+
+/*Narrow an integer sample by dropping `bits` low bits: round (optionally after
+adding dither) and saturate to [minValue, maxValue].*/
+inline int narrowSample(int v, int bits, uint32_t k, bool dither, int minValue,
+		int maxValue) {
+
+	if (dither) {
+
+		v += tpdfDither(k, bits);
+
+	}
+
+	v = (v + (1 << (bits - 1))) >> bits;
+
+	v = v > maxValue ? maxValue : v;
+
+	return v < minValue ? minValue : v;
+
+}
+
+/*Convert one sample between bit depths: widening shifts the value up, narrowing
+rounds it down to the top bits (optionally dithered) and saturates.*/
+template<typename To, typename From> inline To convertSample(From s,
+		uint32_t k, bool dither) {
+
+	const int bits = 8 * ((int) sizeof(From) - (int) sizeof(To));
+
+	if (bits < 0) {
+
+		return (To) (s * (1 << (8 * (sizeof(To) - sizeof(From)) & 31)));
+
+	}
+
+	if (bits == 0) {
+
+		return (To) s;
+
+	}
+
+	return (To) narrowSample(s, bits, k, dither, numeric_limits < To >::min(),
+			numeric_limits < To >::max());
+
+}
+
+}
+
+#endif
@@ -0,0 +1,219 @@
+//=================================================================================
+// Name        : Convolution.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Linear convolution of a signal with an impulse response (FIR filter
+// 				 or room response): direct form for short responses, uniformly
+// 				 partitioned overlap-add FFT convolution otherwise
+//=================================================================================
+
+#include <algorithm>
+#include <vector>
+#include "FFT.h"
+#include "Parallel.h"
+
+#ifndef LIBS_CONVOLUTION_H
+#define LIBS_CONVOLUTION_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// impulse responses shorter than this are convolved directly
+const int DIRECT_CONVOLUTION_TAPS = 64;
+
+/*Direct convolution: O(N*M), y has length N + M - 1. Each output sample is a dot
+product, so output blocks are independent and run in parallel.*/
+inline vector<float> directConvolve(const vector<float>& x,
+		const vector<float>& h) {
+
+	long n = x.size(), m = h.size();
+
+	if (n == 0 || m == 0) {
+
+		return vector<float>();
+
+	}
+
+	vector<float> y(n + m - 1);
+
+	parallelFor(n + m - 1, [&](long begin, long end) {
+
+		for (long k = begin; k < end; ++k) {
+
+			long first = max(0L, k - (n - 1)), last = min(k, m - 1);
+
+			float total = 0.0f;
+
+			for (long j = first; j <= last; ++j) {
+
+				total += h[j] * x[k - j];
+
+			}
+
+			y[k] = total;
+
+		}
+
+	}, 4096);
+
+	return y;
+
+}
+
+/*FFT convolution (uniformly partitioned overlap-add): the impulse response is
+split into P partitions of B taps and the signal into blocks of B samples, all
+transformed with 2B-point FFTs. Output block k is
+	IFFT( sum_j X[k-j] * H[j] )
+overlap-added with the second half of block k-1. Each thread owns a contiguous
+range of output blocks and keeps its own ring of the last P input spectra (the
+frequency-domain delay line), so threads never write to the same output.*/
+inline vector<float> fftConvolve(const vector<float>& x,
+		const vector<float>& h) {
+
+	long n = x.size(), m = h.size();
+
+	if (m < DIRECT_CONVOLUTION_TAPS) {
+
+		return directConvolve(x, h);
+
+	}
+
+	// partition size: bigger blocks mean fewer spectra to multiply per output
+	int b = min(max(FFT::nextPowerOfTwo(m), 256), 16384);
+
+	int fftSize = 2 * b;
+
+	long numPartitions = (m + b - 1) / b;
+
+	long numInputBlocks = (n + b - 1) / b;
+
+	long numOutputBlocks = (n + m - 1 + b - 1) / b;
+
+	FFT fft(fftSize);
+
+	// spectra of the impulse response partitions
+	vector<vector<float>> hRe(numPartitions, vector<float>(fftSize)), hIm(
+			numPartitions, vector<float>(fftSize));
+
+	parallelFor(numPartitions, [&](long begin, long end) {
+
+		vector<float> workRe(fftSize), workIm(fftSize);
+
+		for (long j = begin; j < end; ++j) {
+
+			long len = min((long) b, m - j * b);
+
+			copy(h.begin() + j * b, h.begin() + j * b + len, hRe[j].begin());
+
+			fft.forward(hRe[j].data(), hIm[j].data(), workRe.data(), workIm.data());
+
+		}
+
+	});
+
+	vector<float> y(n + m - 1);
+
+	parallelFor(numOutputBlocks, [&](long k0, long k1) {
+
+		vector<vector<float>> ringRe(numPartitions, vector<float>(fftSize)),
+		ringIm(numPartitions, vector<float>(fftSize));
+
+		vector<float> accRe(fftSize), accIm(fftSize), workRe(fftSize), workIm(
+				fftSize), tail(b);
+
+		// FFT of input block k into its ring slot (zeros outside the signal)
+		auto pushBlock = [&](long k) {
+
+			float* re = ringRe[k % numPartitions].data();
+
+			float* im = ringIm[k % numPartitions].data();
+
+			fill(re, re + fftSize, 0.0f);
+
+			fill(im, im + fftSize, 0.0f);
+
+			if (k < numInputBlocks) {
+
+				long len = min((long) b, n - k * b);
+
+				copy(x.begin() + k * b, x.begin() + k * b + len, re);
+
+				fft.forward(re, im, workRe.data(), workIm.data());
+
+			}
+
+		};
+
+		// block k0 - 1 only supplies the overlap tail for block k0
+		long kStart = max(k0 - 1, 0L);
+
+		// warm up the delay line so block kStart sees its full history
+		for (long k = max(kStart - numPartitions + 1, 0L); k < kStart; ++k) {
+
+			pushBlock(k);
+
+		}
+
+		for (long k = kStart; k < k1; ++k) {
+
+			pushBlock(k);
+
+			fill(accRe.begin(), accRe.end(), 0.0f);
+
+			fill(accIm.begin(), accIm.end(), 0.0f);
+
+			// complex multiply-accumulate over the partitions (vectorized over bins)
+			for (long j = 0; j < numPartitions && j <= k; ++j) {
+
+				if (k - j >= numInputBlocks) {
+
+					continue;
+
+				}
+
+				const float* xr = ringRe[(k - j) % numPartitions].data();
+				const float* xi = ringIm[(k - j) % numPartitions].data();
+				const float* hr = hRe[j].data();
+				const float* hi = hIm[j].data();
+
+				float* ar = accRe.data();
+				float* ai = accIm.data();
+
+				for (int f = 0; f < fftSize; ++f) {
+
+					ar[f] += xr[f] * hr[f] - xi[f] * hi[f];
+
+					ai[f] += xr[f] * hi[f] + xi[f] * hr[f];
+
+				}
+
+			}
+
+			fft.inverse(accRe.data(), accIm.data(), workRe.data(), workIm.data());
+
+			if (k >= k0) {
+
+				long len = min((long) b, n + m - 1 - k * b);
+
+				for (long t = 0; t < len; ++t) {
+
+					y[k * b + t] = accRe[t] + tail[t];
+
+				}
+
+			}
+
+			copy(accRe.begin() + b, accRe.end(), tail.begin());
+
+		}
+
+	}, 1);
+
+	return y;
+
+}
+
+}
+
+#endif
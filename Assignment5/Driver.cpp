@@ -53,26 +53,141 @@ int main(int argc, char* argv[]) { // argc and argv values passed into main
 
 		}
 
+	} else if ((processIntVal(argv[6]) == 4) | (processIntVal(argv[6]) == 6)
+			| (processIntVal(argv[6]) == 8)) {
+
+		// quad, 5.1 and 7.1 (generic N-channel Audio)
+		numChannels = processIntVal(argv[6]);
+
+	} else {
+
+		cout << "Error: noChannels must be 1, 2, 4, 6 or 8." << endl;
+
+		exit(1);
+
 	}
 
-	if (string(argv[7]) == "-o") {
+	string traceFileName, stateFileName, cacheDir;
 
-		outputFileName = argv[8];
+	long cacheLimit = 1024;
 
-		operation = argv[9];
+	bool stats = false;
 
-		position = 9;
+	int blockFrames = 1024;
 
-	} else {
+	position = 7;
+
+	// optional flags: [-o outFileName] [--stats] [--trace traceFileName]
+	// [--block blockFrames] [--slac] [--state stateFileName]
+	// [--cache cacheDir] [--cache-limit megabytes]
+	while (position < argc - 1) {
+
+		if (string(argv[position]) == "-o") {
+
+			outputFileName = argv[++position];
+
+		} else if (string(argv[position]) == "--stats") {
+
+			stats = true;
+
+		} else if (string(argv[position]) == "--state") {
+
+			stateFileName = argv[++position];
+
+		} else if (string(argv[position]) == "--cache") {
+
+			cacheDir = argv[++position];
+
+		} else if (string(argv[position]) == "--cache-limit") {
+
+			cacheLimit = processIntVal(argv[++position]);
+
+		} else if (string(argv[position]) == "--slac") {
+
+			losslessOutput() = true;
+
+		} else if (string(argv[position]) == "--block") {
+
+			blockFrames = processIntVal(argv[++position]);
+
+			if (blockFrames < 1) {
+
+				cerr << "Error: --block must be at least 1 frame." << endl;
+
+				exit(1);
+
+			}
+
+		} else if (string(argv[position]) == "--trace") {
+
+			stats = true;
+
+			traceFileName = argv[++position];
+
+		} else {
+
+			break;
+
+		}
+
+		++position;
+
+	}
+
+	operation = argv[position];
+
+	if (stats) {
+
+		Profiler::instance().enable(traceFileName);
+
+	}
+
+	// result cache: jobs reading stdin, updating an index or a state file, or
+	// reading sources named inside an edit list are never cached
+	ResultCache cache(cacheDir, cacheLimit);
+
+	string jobKey;
+
+	if (!cacheDir.empty() && stateFileName.empty() && operation != "-stream"
+			&& operation != "-fpindex" && operation != "-edl") {
+
+		jobKey = cache.jobKey(sampleRateInHz, bitCount, numChannels,
+				losslessOutput(), argv, position, argc);
+
+		if (cache.restore(jobKey, outputFileName)) {
 
-		operation = argv[7];
+			if (stats) {
+
+				Profiler::instance().report(cout);
+
+			}
+
+			return 0;
+
+		}
 
-		position = 7;
+		cache.record();
 
 	}
 
-	// audio operation (-add)
-	if (operation == "-add") {
+	// quad, 5.1 and 7.1 files (see multichannelFile for the operations)
+	if (numChannels > 2) {
+
+		cout << "Performing operation: " << operation << endl;
+
+		if (!stateFileName.empty()) {
+
+			cout << "Error: --state only supports mono and stereo files." << endl;
+
+			exit(1);
+
+		}
+
+		multichannel(sampleRateInHz, bitCount, numChannels, argv, position,
+				operation, outputFileName);
+
+		// audio operation (-add)
+	} else if (operation == "-add") {
 
 		cout << "Performing operation: " << operation << endl;
 
@@ -169,7 +284,17 @@ int main(int argc, char* argv[]) { // argc and argv values passed into main
 
 		inputFileName1 = argv[++position];
 
-		rms(sampleRateInHz, bitCount, numChannels, inputFileName1);
+		if (!stateFileName.empty()) {
+
+			incremental(sampleRateInHz, bitCount, numChannels, inputFileName1,
+					outputFileName, stateFileName, operation, make_pair(0.0f, 0.0f),
+					"");
+
+		} else {
+
+			rms(sampleRateInHz, bitCount, numChannels, inputFileName1);
+
+		}
 
 		// audio operation (-rev)
 	} else if (operation == "-rev") {
@@ -197,14 +322,459 @@ int main(int argc, char* argv[]) { // argc and argv values passed into main
 
 			inputFileName1 = argv[++position];
 
-			normalStereo(sampleRateInHz, bitCount, numChannels, inputFileName1,
-					outputFileName, p);
+			if (!stateFileName.empty()) {
+
+				incremental(sampleRateInHz, bitCount, numChannels, inputFileName1,
+						outputFileName, stateFileName, operation, p, "");
+
+			} else {
+
+				normalStereo(sampleRateInHz, bitCount, numChannels,
+						inputFileName1, outputFileName, p);
+
+			}
+
+		} else {
+
+			inputFileName1 = argv[++position];
+
+			if (!stateFileName.empty()) {
+
+				incremental(sampleRateInHz, bitCount, numChannels, inputFileName1,
+						outputFileName, stateFileName, operation,
+						make_pair(r1, r1), "");
+
+			} else {
+
+				normalMono(sampleRateInHz, bitCount, numChannels, inputFileName1,
+						outputFileName, r1);
+
+			}
+
+		}
+
+		// audio operation (-conv)
+	} else if (operation == "-conv") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		inputFileName1 = argv[++position];
+
+		inputFileName2 = argv[++position];
+
+		convolve(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				inputFileName2, outputFileName);
+
+		// audio operation (-filter spec)
+	} else if (operation == "-filter") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		string spec = argv[++position];
+
+		inputFileName1 = argv[++position];
+
+		if (!stateFileName.empty()) {
+
+			incremental(sampleRateInHz, bitCount, numChannels, inputFileName1,
+					outputFileName, stateFileName, operation, make_pair(0.0f, 0.0f),
+					spec);
+
+		} else {
+
+			filter(sampleRateInHz, bitCount, numChannels, inputFileName1,
+					outputFileName, spec);
+
+		}
+
+		// audio operation (-compress thresholdDb ratio attackMs releaseMs lookaheadMs [-unlinked])
+	} else if (operation == "-compress") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		float thresholdDb = processFloatVal(argv[++position]);
+
+		float ratio = processFloatVal(argv[++position]);
+
+		float attackMs = processFloatVal(argv[++position]);
+
+		float releaseMs = processFloatVal(argv[++position]);
+
+		float lookaheadMs = processFloatVal(argv[++position]);
+
+		bool linked = true;
+
+		if (string(argv[position + 1]) == "-unlinked") {
+
+			linked = false;
+
+			++position;
+
+		}
+
+		inputFileName1 = argv[++position];
+
+		compress(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName,
+				Compressor(thresholdDb, ratio, attackMs, releaseMs, lookaheadMs,
+						sampleRateInHz), linked);
+
+		// audio operation (-limit thresholdDb releaseMs lookaheadMs [-unlinked])
+	} else if (operation == "-limit") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		float thresholdDb = processFloatVal(argv[++position]);
+
+		float releaseMs = processFloatVal(argv[++position]);
+
+		float lookaheadMs = processFloatVal(argv[++position]);
+
+		bool linked = true;
+
+		if (string(argv[position + 1]) == "-unlinked") {
+
+			linked = false;
+
+			++position;
+
 		}
 
 		inputFileName1 = argv[++position];
 
-		normalMono(sampleRateInHz, bitCount, numChannels, inputFileName1,
-				outputFileName, r1);
+		compress(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName,
+				Compressor::limiter(thresholdDb, releaseMs, lookaheadMs,
+						sampleRateInHz), linked);
+
+		// audio operation (-trim threshold minDuration)
+	} else if (operation == "-trim") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		int threshold = processIntVal(argv[++position]);
+
+		float minDuration = processFloatVal(argv[++position]);
+
+		inputFileName1 = argv[++position];
+
+		trim(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName, threshold, minDuration);
+
+		// audio operation (-silence threshold minDuration)
+	} else if (operation == "-silence") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		int threshold = processIntVal(argv[++position]);
+
+		float minDuration = processFloatVal(argv[++position]);
+
+		inputFileName1 = argv[++position];
+
+		silence(sampleRateInHz, bitCount, numChannels, inputFileName1, threshold,
+				minDuration);
+
+		// audio operation (-xfade s1 s2)
+	} else if (operation == "-xfade") {
+
+		float s1, s2;
+
+		cout << "Performing operation: " << operation << endl;
+
+		s1 = processFloatVal(argv[++position]);
+
+		if (numChannels == 2) {
+
+			s2 = processFloatVal(argv[++position]);
+
+			pair<float, float> p = make_pair(s1, s2);
+
+			inputFileName1 = argv[++position];
+
+			inputFileName2 = argv[++position];
+
+			crossfadeStereo(sampleRateInHz, bitCount, numChannels, inputFileName1,
+					inputFileName2, outputFileName, p);
+
+		} else {
+
+			inputFileName1 = argv[++position];
+
+			inputFileName2 = argv[++position];
+
+			crossfadeMono(sampleRateInHz, bitCount, numChannels, inputFileName1,
+					inputFileName2, outputFileName, s1);
+
+		}
+
+		// audio operation (-convert bitCount noChannels [g1 g2] [-dither])
+	} else if (operation == "-convert") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		int targetBits = string(argv[++position]) == "8-bit" ? 8 : 16;
+
+		int targetChannels = processIntVal(argv[++position]);
+
+		pair<float, float> gains = make_pair(0.5f, 0.5f);
+
+		if (numChannels == 2 && targetChannels == 1) {
+
+			gains.first = processFloatVal(argv[++position]);
+
+			gains.second = processFloatVal(argv[++position]);
+
+		}
+
+		bool dither = false;
+
+		if (string(argv[position + 1]) == "-dither") {
+
+			dither = true;
+
+			++position;
+
+		}
+
+		inputFileName1 = argv[++position];
+
+		convert(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName, targetBits, targetChannels, gains, dither);
+
+		// audio operation (-stream <ops>): stdin to stdout, block by block
+	} else if (operation == "-stream") {
+
+		// stdout carries the audio, so messages go to stderr
+		cerr << "Performing operation: " << operation << endl;
+
+		vector<StreamOp> ops;
+
+		while (position + 1 < argc) {
+
+			StreamOp op;
+
+			op.name = argv[++position];
+
+			op.vol = make_pair(1.0f, 1.0f);
+
+			if (op.name == "-v") {
+
+				op.vol.first = processFloatVal(argv[++position]);
+
+				op.vol.second = op.vol.first;
+
+				if (numChannels == 2) {
+
+					op.vol.second = processFloatVal(argv[++position]);
+
+				}
+
+			} else if (op.name == "-add" || op.name == "-filter") {
+
+				op.arg = argv[++position];
+
+			} else {
+
+				cerr << "Incorrect stream operation!" << endl;
+
+				exit(1);
+
+			}
+
+			ops.push_back(op);
+
+		}
+
+		stream(sampleRateInHz, bitCount, numChannels, blockFrames, ops);
+
+		// audio operation (-split spec)
+	} else if (operation == "-split") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		string spec = argv[++position];
+
+		inputFileName1 = argv[++position];
+
+		split(sampleRateInHz, bitCount, numChannels, inputFileName1, spec,
+				outputFileName);
+
+		// audio operation (-fpindex indexFile soundFile1 [soundFile2 ...])
+	} else if (operation == "-fpindex") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		string indexFileName = argv[++position];
+
+		vector<string> inputFileNames;
+
+		while (position + 1 < argc) {
+
+			inputFileNames.push_back(argv[++position]);
+
+		}
+
+		fingerprintIndex(sampleRateInHz, bitCount, numChannels, indexFileName,
+				inputFileNames);
+
+		// audio operation (-fpquery indexFile)
+	} else if (operation == "-fpquery") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		string indexFileName = argv[++position];
+
+		inputFileName1 = argv[++position];
+
+		fingerprintQuery(sampleRateInHz, bitCount, numChannels, indexFileName,
+				inputFileName1);
+
+		// audio operation (-align [-mix])
+	} else if (operation == "-align") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		bool mix = false;
+
+		if (string(argv[position + 1]) == "-mix") {
+
+			mix = true;
+
+			++position;
+
+		}
+
+		inputFileName1 = argv[++position];
+
+		inputFileName2 = argv[++position];
+
+		align(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				inputFileName2, outputFileName, mix);
+
+		// audio operation (-spectrogram size hop [-window w] [-scale s] [-format f])
+	} else if (operation == "-spectrogram") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		int size = processIntVal(argv[++position]);
+
+		int hop = processIntVal(argv[++position]);
+
+		string window = "hann", scale = "linear", format = "pgm";
+
+		while (position + 2 < argc) {
+
+			string option = argv[position + 1];
+
+			if (option == "-window") {
+
+				window = argv[position + 2];
+
+			} else if (option == "-scale") {
+
+				scale = argv[position + 2];
+
+			} else if (option == "-format") {
+
+				format = argv[position + 2];
+
+			} else {
+
+				break;
+
+			}
+
+			position += 2;
+
+		}
+
+		inputFileName1 = argv[++position];
+
+		spectrogram(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName, size, hop, window, scale, format);
+
+		// audio operation (-stats [-bins n])
+	} else if (operation == "-stats") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		int bins = 32;
+
+		if (string(argv[position + 1]) == "-bins") {
+
+			bins = processIntVal(argv[position + 2]);
+
+			position += 2;
+
+		}
+
+		inputFileName1 = argv[++position];
+
+		audioStats(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName, bins);
+
+		// audio operation (-fade [-exp] s1 s2 | -envelope [-exp] t1:g1,t2:g2,...)
+	} else if (operation == "-fade" || operation == "-envelope") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		bool exponential = string(argv[position + 1]) == "-exp";
+
+		position += exponential ? 1 : 0;
+
+		string spec;
+
+		pair<float, float> fades;
+
+		if (operation == "-fade") {
+
+			fades.first = processFloatVal(argv[++position]);
+
+			fades.second = processFloatVal(argv[++position]);
+
+		} else {
+
+			spec = argv[++position];
+
+		}
+
+		inputFileName1 = argv[++position];
+
+		envelope(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName, spec, fades, exponential);
+
+		// audio operation (-edl editList soundFile1)
+	} else if (operation == "-edl") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		string editListFileName = argv[++position];
+
+		inputFileName1 = argv[++position];
+
+		editList(sampleRateInHz, bitCount, numChannels, editListFileName,
+				inputFileName1, outputFileName);
+
+		// audio operation (-encode soundFile1)
+	} else if (operation == "-encode") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		inputFileName1 = argv[++position];
+
+		encode(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName);
+
+		// audio operation (-decode soundFile1)
+	} else if (operation == "-decode") {
+
+		cout << "Performing operation: " << operation << endl;
+
+		inputFileName1 = argv[++position];
+
+		decode(sampleRateInHz, bitCount, numChannels, inputFileName1,
+				outputFileName);
 
 	} else {
 
@@ -214,6 +784,18 @@ int main(int argc, char* argv[]) { // argc and argv values passed into main
 
 	}
 
+	if (!jobKey.empty()) {
+
+		cache.store(jobKey, outputFileName);
+
+	}
+
+	if (stats) {
+
+		Profiler::instance().report(operation == "-stream" ? cerr : cout);
+
+	}
+
 	return 0;
 
 }
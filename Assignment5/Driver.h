@@ -6,8 +6,19 @@
 // 				 using various editing operations - written in C++, Ansi-style
 //=================================================================================
 
+#include <chrono>
+#include <future>
 #include <iostream>
 #include "Audio.h"
+#include "Stream.h"
+#include "Split.h"
+#include "Fingerprint.h"
+#include "Align.h"
+#include "Incremental.h"
+#include "Spectrogram.h"
+#include "Cache.h"
+#include "Analysis.h"
+#include "EditList.h"
 
 #ifndef LIBS_DRIVER_H
 #define LIBS_DRIVER_H
@@ -16,6 +27,17 @@ using namespace DPLKYL002;
 
 namespace DPLKYL002 {
 
+/*Start loading an input file on its own thread; the operations with two inputs
+load the second one this way while the first loads, so their reads overlap.*/
+template<typename Frame> future<Audio<Frame>> loadAsync(string inputFileName,
+		int samplingRate) {
+
+	return async(launch::async, [inputFileName, samplingRate]() mutable {
+		return Audio<Frame>(inputFileName, samplingRate);
+	});
+
+}
+
 void radd(int samplingRate, int bCount, int numChannels, string inputFileName1,
 		string inputFileName2, pair<int, int> r, string outputFileName) {
 
@@ -23,22 +45,26 @@ void radd(int samplingRate, int bCount, int numChannels, string inputFileName1,
 
 		if (numChannels == 1) {
 
-			Audio<int8_t> audioFile1 = Audio<int8_t>(inputFileName1,
+			future<Audio<int8_t>> input2 = loadAsync<int8_t>(inputFileName2,
 					samplingRate);
 
-			Audio<int8_t> audioFile2 = Audio<int8_t>(inputFileName2,
+			Audio<int8_t> audioFile1 = Audio<int8_t>(inputFileName1,
 					samplingRate);
 
+			Audio<int8_t> audioFile2 = input2.get();
+
 			Audio<int8_t> audio = audioFile1.rangedAdd(audioFile2, r);
 			audio.saveAudioFile(outputFileName);
 
 		} else {
 
+			future<Audio<pair<int8_t, int8_t>>> input2 = loadAsync<
+					pair<int8_t, int8_t>>(inputFileName2, samplingRate);
+
 			Audio<pair<int8_t, int8_t>> audioFile1 =
 					Audio<pair<int8_t, int8_t>>(inputFileName1, samplingRate);
 
-			Audio<pair<int8_t, int8_t>> audioFile2 =
-					Audio<pair<int8_t, int8_t>>(inputFileName2, samplingRate);
+			Audio<pair<int8_t, int8_t>> audioFile2 = input2.get();
 
 			Audio<pair<int8_t, int8_t>> audio = audioFile1.rangedAdd(audioFile2,
 					r);
@@ -51,23 +77,27 @@ void radd(int samplingRate, int bCount, int numChannels, string inputFileName1,
 
 		if (numChannels == 1) {
 
-			Audio<int16_t> audioFile1 = Audio<int16_t>(inputFileName1,
+			future<Audio<int16_t>> input2 = loadAsync<int16_t>(inputFileName2,
 					samplingRate);
 
-			Audio<int16_t> audioFile2 = Audio<int16_t>(inputFileName2,
+			Audio<int16_t> audioFile1 = Audio<int16_t>(inputFileName1,
 					samplingRate);
 
+			Audio<int16_t> audioFile2 = input2.get();
+
 			Audio<int16_t> audio = audioFile1.rangedAdd(audioFile2, r);
 
 			audio.saveAudioFile(outputFileName);
 
 		} else {
 
+			future<Audio<pair<int16_t, int16_t>>> input2 = loadAsync<
+					pair<int16_t, int16_t>>(inputFileName2, samplingRate);
+
 			Audio<pair<int16_t, int16_t>> audioFile1 = Audio<
 					pair<int16_t, int16_t>>(inputFileName1, samplingRate);
 
-			Audio<pair<int16_t, int16_t>> audioFile2 = Audio<
-					pair<int16_t, int16_t>>(inputFileName2, samplingRate);
+			Audio<pair<int16_t, int16_t>> audioFile2 = input2.get();
 
 			Audio<pair<int16_t, int16_t>> audio = audioFile1.rangedAdd(
 					audioFile2, r);
@@ -87,21 +117,25 @@ void cat(int samplingRate, int bCount, int numChannels, string inputFileName1,
 
 		if (numChannels == 1) {
 
-			Audio<int8_t> audioFile1 = Audio<int8_t>(inputFileName1,
+			future<Audio<int8_t>> input2 = loadAsync<int8_t>(inputFileName2,
 					samplingRate);
 
-			Audio<int8_t> audioFile2 = Audio<int8_t>(inputFileName2,
+			Audio<int8_t> audioFile1 = Audio<int8_t>(inputFileName1,
 					samplingRate);
 
+			Audio<int8_t> audioFile2 = input2.get();
+
 			Audio<int8_t> audio = audioFile1 | audioFile2;
 			audio.saveAudioFile(outputFileName);
 
 		} else {
+			future<Audio<pair<int8_t, int8_t>>> input2 = loadAsync<
+					pair<int8_t, int8_t>>(inputFileName2, samplingRate);
+
 			Audio<pair<int8_t, int8_t>> audioFile1 =
 					Audio<pair<int8_t, int8_t>>(inputFileName1, samplingRate);
 
-			Audio<pair<int8_t, int8_t>> audioFile2 =
-					Audio<pair<int8_t, int8_t>>(inputFileName2, samplingRate);
+			Audio<pair<int8_t, int8_t>> audioFile2 = input2.get();
 
 			Audio<pair<int8_t, int8_t>> audio = audioFile1 | audioFile2;
 
@@ -111,23 +145,27 @@ void cat(int samplingRate, int bCount, int numChannels, string inputFileName1,
 	} else {
 		if (numChannels == 1) {
 
-			Audio<int16_t> audioFile1 = Audio<int16_t>(inputFileName1,
+			future<Audio<int16_t>> input2 = loadAsync<int16_t>(inputFileName2,
 					samplingRate);
 
-			Audio<int16_t> audioFile2 = Audio<int16_t>(inputFileName2,
+			Audio<int16_t> audioFile1 = Audio<int16_t>(inputFileName1,
 					samplingRate);
 
+			Audio<int16_t> audioFile2 = input2.get();
+
 			Audio<int16_t> audio = audioFile1 | audioFile2;
 
 			audio.saveAudioFile(outputFileName);
 
 		} else {
 
+			future<Audio<pair<int16_t, int16_t>>> input2 = loadAsync<
+					pair<int16_t, int16_t>>(inputFileName2, samplingRate);
+
 			Audio<pair<int16_t, int16_t>> audioFile1 = Audio<
 					pair<int16_t, int16_t>>(inputFileName1, samplingRate);
 
-			Audio<pair<int16_t, int16_t>> audioFile2 = Audio<
-					pair<int16_t, int16_t>>(inputFileName2, samplingRate);
+			Audio<pair<int16_t, int16_t>> audioFile2 = input2.get();
 
 			Audio<pair<int16_t, int16_t>> audio = audioFile1 | audioFile2;
 
@@ -146,23 +184,27 @@ void add(int samplingRate, int bCount, int numChannels, string inputFileName1,
 
 		if (numChannels == 1) {
 
-			Audio<int8_t> audioFile1 = Audio<int8_t>(inputFileName1,
+			future<Audio<int8_t>> input2 = loadAsync<int8_t>(inputFileName2,
 					samplingRate);
 
-			Audio<int8_t> audioFile2 = Audio<int8_t>(inputFileName2,
+			Audio<int8_t> audioFile1 = Audio<int8_t>(inputFileName1,
 					samplingRate);
 
+			Audio<int8_t> audioFile2 = input2.get();
+
 			Audio<int8_t> audio = audioFile1 + audioFile2;
 
 			audio.saveAudioFile(outputFileName);
 
 		} else {
 
+			future<Audio<pair<int8_t, int8_t>>> input2 = loadAsync<
+					pair<int8_t, int8_t>>(inputFileName2, samplingRate);
+
 			Audio<pair<int8_t, int8_t>> audioFile1 =
 					Audio<pair<int8_t, int8_t>>(inputFileName1, samplingRate);
 
-			Audio<pair<int8_t, int8_t>> audioFile2 =
-					Audio<pair<int8_t, int8_t>>(inputFileName2, samplingRate);
+			Audio<pair<int8_t, int8_t>> audioFile2 = input2.get();
 
 			Audio<pair<int8_t, int8_t>> audio = audioFile1 + audioFile2;
 
@@ -174,23 +216,27 @@ void add(int samplingRate, int bCount, int numChannels, string inputFileName1,
 
 		if (numChannels == 1) {
 
-			Audio<int16_t> audioFile1 = Audio<int16_t>(inputFileName1,
+			future<Audio<int16_t>> input2 = loadAsync<int16_t>(inputFileName2,
 					samplingRate);
 
-			Audio<int16_t> audioFile2 = Audio<int16_t>(inputFileName2,
+			Audio<int16_t> audioFile1 = Audio<int16_t>(inputFileName1,
 					samplingRate);
 
+			Audio<int16_t> audioFile2 = input2.get();
+
 			Audio<int16_t> audio = audioFile1 + audioFile2;
 
 			audio.saveAudioFile(outputFileName);
 
 		} else {
 
+			future<Audio<pair<int16_t, int16_t>>> input2 = loadAsync<
+					pair<int16_t, int16_t>>(inputFileName2, samplingRate);
+
 			Audio<pair<int16_t, int16_t>> audioFile1 = Audio<
 					pair<int16_t, int16_t>>(inputFileName1, samplingRate);
 
-			Audio<pair<int16_t, int16_t>> audioFile2 = Audio<
-					pair<int16_t, int16_t>>(inputFileName2, samplingRate);
+			Audio<pair<int16_t, int16_t>> audioFile2 = input2.get();
 
 			Audio<pair<int16_t, int16_t>> audio = audioFile1 + audioFile2;
 
@@ -209,19 +255,26 @@ void cut(int samplingRate, int bCount, int numChannels, string inputFileName,
 
 		if (numChannels == 1) {
 
-			Audio<int8_t> audioFile = Audio<int8_t>(inputFileName,
-					samplingRate);
+			Audio<int8_t> audioFirst = Audio<int8_t>(inputFileName,
+					samplingRate, 0, range.first);
 
-			Audio<int8_t> audio = audioFile ^ range;
+			Audio<int8_t> audioSecond = Audio<int8_t>(inputFileName,
+					samplingRate, range.second + 1);
+
+			Audio<int8_t> audio = audioFirst | audioSecond;
 
 			audio.saveAudioFile(outputFileName);
 
 		} else {
 
-			Audio<pair<int8_t, int8_t>> audioFile = Audio<pair<int8_t, int8_t>>(
-					inputFileName, samplingRate);
+			Audio<pair<int8_t, int8_t>> audioFirst = Audio<pair<int8_t, int8_t>>(
+					inputFileName, samplingRate, 0, range.first);
+
+			Audio<pair<int8_t, int8_t>> audioSecond = Audio<
+					pair<int8_t, int8_t>>(inputFileName, samplingRate,
+					range.second + 1);
 
-			Audio<pair<int8_t, int8_t>> audio = audioFile ^ range;
+			Audio<pair<int8_t, int8_t>> audio = audioFirst | audioSecond;
 
 			audio.saveAudioFile(outputFileName);
 
@@ -231,19 +284,27 @@ void cut(int samplingRate, int bCount, int numChannels, string inputFileName,
 
 		if (numChannels == 1) {
 
-			Audio<int16_t> audioFile = Audio<int16_t>(inputFileName,
-					samplingRate);
+			Audio<int16_t> audioFirst = Audio<int16_t>(inputFileName,
+					samplingRate, 0, range.first);
 
-			Audio<int16_t> audio = audioFile ^ range;
+			Audio<int16_t> audioSecond = Audio<int16_t>(inputFileName,
+					samplingRate, range.second + 1);
+
+			Audio<int16_t> audio = audioFirst | audioSecond;
 
 			audio.saveAudioFile(outputFileName);
 
 		} else {
 
-			Audio<pair<int16_t, int16_t>> audioFile = Audio<
-					pair<int16_t, int16_t>>(inputFileName, samplingRate);
+			Audio<pair<int16_t, int16_t>> audioFirst = Audio<
+					pair<int16_t, int16_t>>(inputFileName, samplingRate, 0,
+					range.first);
+
+			Audio<pair<int16_t, int16_t>> audioSecond = Audio<
+					pair<int16_t, int16_t>>(inputFileName, samplingRate,
+					range.second + 1);
 
-			Audio<pair<int16_t, int16_t>> audio = audioFile ^ range;
+			Audio<pair<int16_t, int16_t>> audio = audioFirst | audioSecond;
 
 			audio.saveAudioFile(outputFileName);
 
@@ -307,7 +368,8 @@ void normalMono(int samplingRate, int bCount, int numChannels,
 
 	if (bCount == 8) {
 
-		Audio<int8_t> audioFile = Audio<int8_t>(inputFileName, samplingRate);
+		Audio<int8_t> audioFile = Audio<int8_t>(inputFileName, samplingRate, 0,
+				-1, true);
 
 		Audio<int8_t> audio = audioFile.normalizeSound(r1);
 
@@ -315,7 +377,8 @@ void normalMono(int samplingRate, int bCount, int numChannels,
 
 	} else {
 
-		Audio<int16_t> audioFile = Audio<int16_t>(inputFileName, samplingRate);
+		Audio<int16_t> audioFile = Audio<int16_t>(inputFileName, samplingRate, 0,
+				-1, true);
 
 		Audio<int16_t> audio = audioFile.normalizeSound(r1);
 
@@ -331,7 +394,7 @@ void normalStereo(int samplingRate, int bCount, int numChannels,
 	if (bCount == 8) {
 
 		Audio<pair<int8_t, int8_t>> audioFile = Audio<pair<int8_t, int8_t>>(
-				inputFileName, samplingRate);
+				inputFileName, samplingRate, 0, -1, true);
 
 		Audio<pair<int8_t, int8_t>> audio = audioFile.normalizeSound(p);
 
@@ -340,7 +403,7 @@ void normalStereo(int samplingRate, int bCount, int numChannels,
 	} else {
 
 		Audio<pair<int16_t, int16_t>> audioFile = Audio<pair<int16_t, int16_t>>(
-				inputFileName, samplingRate);
+				inputFileName, samplingRate, 0, -1, true);
 
 		Audio<pair<int16_t, int16_t>> audio = audioFile.normalizeSound(p);
 
@@ -405,14 +468,14 @@ void rms(int samplingRate, int bCount, int numChannels, string inputFileName) {
 		if (numChannels == 1) {
 
 			Audio<int8_t> audioFile = Audio<int8_t>(inputFileName,
-					samplingRate);
+					samplingRate, 0, -1, true);
 
 			cout << "Audio file RMS: " << audioFile.computeRMS() << endl;
 
 		} else {
 
 			Audio<pair<int8_t, int8_t>> audioFile = Audio<pair<int8_t, int8_t>>(
-					inputFileName, samplingRate);
+					inputFileName, samplingRate, 0, -1, true);
 
 			cout << "Audio file left channel RMS: " << audioFile.computeRMS().first
 					<< endl;
@@ -427,14 +490,15 @@ void rms(int samplingRate, int bCount, int numChannels, string inputFileName) {
 		if (numChannels == 1) {
 
 			Audio<int16_t> audioFile = Audio<int16_t>(inputFileName,
-					samplingRate);
+					samplingRate, 0, -1, true);
 
 			cout << "Audio file RMS: " << audioFile.computeRMS() << endl;
 
 		} else {
 
 			Audio<pair<int16_t, int16_t>> audioFile = Audio<
-					pair<int16_t, int16_t>>(inputFileName, samplingRate);
+					pair<int16_t, int16_t>>(inputFileName, samplingRate, 0, -1,
+					true);
 
 			cout << "Audio file left channel RMS: " << audioFile.computeRMS().first
 					<< endl;
@@ -448,27 +512,1599 @@ void rms(int samplingRate, int bCount, int numChannels, string inputFileName) {
 
 }
 
-int processIntVal(char* val) {
+void convolve(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string impulseFileName, string outputFileName) {
 
-	stringstream ss(val);
+	if (bCount == 8) {
 
-	int value;
+		if (numChannels == 1) {
 
-	ss >> value;
+			Audio<int8_t> audioFile = Audio<int8_t>(inputFileName,
+					samplingRate);
 
-	return value;
+			Audio<int8_t> impulseFile = Audio<int8_t>(impulseFileName,
+					samplingRate);
+
+			Audio<int8_t> audio = audioFile.convolve(impulseFile);
+
+			audio.saveAudioFile(outputFileName);
+
+		} else {
+
+			Audio<pair<int8_t, int8_t>> audioFile = Audio<pair<int8_t, int8_t>>(
+					inputFileName, samplingRate);
+
+			Audio<pair<int8_t, int8_t>> impulseFile =
+					Audio<pair<int8_t, int8_t>>(impulseFileName, samplingRate);
+
+			Audio<pair<int8_t, int8_t>> audio = audioFile.convolve(impulseFile);
+
+			audio.saveAudioFile(outputFileName);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			Audio<int16_t> audioFile = Audio<int16_t>(inputFileName,
+					samplingRate);
+
+			Audio<int16_t> impulseFile = Audio<int16_t>(impulseFileName,
+					samplingRate);
+
+			Audio<int16_t> audio = audioFile.convolve(impulseFile);
+
+			audio.saveAudioFile(outputFileName);
+
+		} else {
+
+			Audio<pair<int16_t, int16_t>> audioFile = Audio<
+					pair<int16_t, int16_t>>(inputFileName, samplingRate);
+
+			Audio<pair<int16_t, int16_t>> impulseFile = Audio<
+					pair<int16_t, int16_t>>(impulseFileName, samplingRate);
+
+			Audio<pair<int16_t, int16_t>> audio = audioFile.convolve(
+					impulseFile);
+
+			audio.saveAudioFile(outputFileName);
+
+		}
+
+	}
 
 }
 
-float processFloatVal(char* val) {
+void filter(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName, string spec) {
 
-	stringstream ss(val);
+	BiquadChain chain = BiquadChain::parse(spec, samplingRate, numChannels);
 
-	float value;
+	if (bCount == 8) {
 
-	ss >> value;
+		if (numChannels == 1) {
 
-	return value;
+			Audio<int8_t> audioFile = Audio<int8_t>(inputFileName,
+					samplingRate);
+
+			audioFile.filter(chain);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		} else {
+
+			Audio<pair<int8_t, int8_t>> audioFile = Audio<pair<int8_t, int8_t>>(
+					inputFileName, samplingRate);
+
+			audioFile.filter(chain);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			Audio<int16_t> audioFile = Audio<int16_t>(inputFileName,
+					samplingRate);
+
+			audioFile.filter(chain);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		} else {
+
+			Audio<pair<int16_t, int16_t>> audioFile = Audio<
+					pair<int16_t, int16_t>>(inputFileName, samplingRate);
+
+			audioFile.filter(chain);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		}
+
+	}
+
+}
+
+// compress / limit a sound file (linked only matters for stereo)
+void compress(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName, Compressor compressor,
+		bool linked) {
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			Audio<int8_t> audioFile = Audio<int8_t>(inputFileName,
+					samplingRate);
+
+			audioFile.compress(compressor);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		} else {
+
+			Audio<pair<int8_t, int8_t>> audioFile = Audio<pair<int8_t, int8_t>>(
+					inputFileName, samplingRate);
+
+			audioFile.compress(compressor, linked);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			Audio<int16_t> audioFile = Audio<int16_t>(inputFileName,
+					samplingRate);
+
+			audioFile.compress(compressor);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		} else {
+
+			Audio<pair<int16_t, int16_t>> audioFile = Audio<
+					pair<int16_t, int16_t>>(inputFileName, samplingRate);
+
+			audioFile.compress(compressor, linked);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		}
+
+	}
+
+}
+
+void trim(int samplingRate, int bCount, int numChannels, string inputFileName,
+		string outputFileName, int threshold, float minDuration) {
+
+	long minSamples = (long) (minDuration * samplingRate);
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			Audio<int8_t> audioFile = Audio<int8_t>(inputFileName,
+					samplingRate);
+
+			audioFile.trimSilence(threshold, minSamples);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		} else {
+
+			Audio<pair<int8_t, int8_t>> audioFile = Audio<pair<int8_t, int8_t>>(
+					inputFileName, samplingRate);
+
+			audioFile.trimSilence(threshold, minSamples);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			Audio<int16_t> audioFile = Audio<int16_t>(inputFileName,
+					samplingRate);
+
+			audioFile.trimSilence(threshold, minSamples);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		} else {
+
+			Audio<pair<int16_t, int16_t>> audioFile = Audio<
+					pair<int16_t, int16_t>>(inputFileName, samplingRate);
+
+			audioFile.trimSilence(threshold, minSamples);
+
+			audioFile.saveAudioFile(outputFileName);
+
+		}
+
+	}
+
+}
+
+void printSilence(const vector<pair<long, long>>& runs, int samplingRate) {
+
+	cout << "Silent regions: " << runs.size() << endl;
+
+	for (int k = 0; k < runs.size(); ++k) {
+
+		cout << runs[k].first / (float) samplingRate << "s - "
+				<< runs[k].second / (float) samplingRate << "s ("
+				<< (runs[k].second - runs[k].first) / (float) samplingRate
+				<< "s)" << endl;
+
+	}
+
+}
+
+void silence(int samplingRate, int bCount, int numChannels,
+		string inputFileName, int threshold, float minDuration) {
+
+	long minSamples = (long) (minDuration * samplingRate);
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			Audio<int8_t> audioFile = Audio<int8_t>(inputFileName,
+					samplingRate);
+
+			printSilence(audioFile.findSilence(threshold, minSamples),
+					samplingRate);
+
+		} else {
+
+			Audio<pair<int8_t, int8_t>> audioFile = Audio<pair<int8_t, int8_t>>(
+					inputFileName, samplingRate);
+
+			printSilence(audioFile.findSilence(threshold, minSamples),
+					samplingRate);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			Audio<int16_t> audioFile = Audio<int16_t>(inputFileName,
+					samplingRate);
+
+			printSilence(audioFile.findSilence(threshold, minSamples),
+					samplingRate);
+
+		} else {
+
+			Audio<pair<int16_t, int16_t>> audioFile = Audio<
+					pair<int16_t, int16_t>>(inputFileName, samplingRate);
+
+			printSilence(audioFile.findSilence(threshold, minSamples),
+					samplingRate);
+
+		}
+
+	}
+
+}
+
+void crossfadeMono(int samplingRate, int bCount, int numChannels,
+		string inputFileName1, string inputFileName2, string outputFileName,
+		float seconds) {
+
+	int overlap = (int) (seconds * samplingRate);
+
+	if (bCount == 8) {
+
+		future<Audio<int8_t>> input2 = loadAsync<int8_t>(inputFileName2,
+				samplingRate);
+
+		Audio<int8_t> audioFile1 = Audio<int8_t>(inputFileName1, samplingRate);
+
+		Audio<int8_t> audioFile2 = input2.get();
+
+		Audio<int8_t> audio = audioFile1.crossfade(audioFile2, overlap);
+
+		audio.saveAudioFile(outputFileName);
+
+	} else {
+
+		future<Audio<int16_t>> input2 = loadAsync<int16_t>(inputFileName2,
+				samplingRate);
+
+		Audio<int16_t> audioFile1 = Audio<int16_t>(inputFileName1, samplingRate);
+
+		Audio<int16_t> audioFile2 = input2.get();
+
+		Audio<int16_t> audio = audioFile1.crossfade(audioFile2, overlap);
+
+		audio.saveAudioFile(outputFileName);
+
+	}
+
+}
+
+void crossfadeStereo(int samplingRate, int bCount, int numChannels,
+		string inputFileName1, string inputFileName2, string outputFileName,
+		pair<float, float> seconds) {
+
+	pair<int, int> overlap = make_pair((int) (seconds.first * samplingRate),
+			(int) (seconds.second * samplingRate));
+
+	if (bCount == 8) {
+
+		future<Audio<pair<int8_t, int8_t>>> input2 = loadAsync<
+				pair<int8_t, int8_t>>(inputFileName2, samplingRate);
+
+		Audio<pair<int8_t, int8_t>> audioFile1 = Audio<pair<int8_t, int8_t>>(
+				inputFileName1, samplingRate);
+
+		Audio<pair<int8_t, int8_t>> audioFile2 = input2.get();
+
+		Audio<pair<int8_t, int8_t>> audio = audioFile1.crossfade(audioFile2,
+				overlap);
+
+		audio.saveAudioFile(outputFileName);
+
+	} else {
+
+		future<Audio<pair<int16_t, int16_t>>> input2 = loadAsync<
+				pair<int16_t, int16_t>>(inputFileName2, samplingRate);
+
+		Audio<pair<int16_t, int16_t>> audioFile1 = Audio<pair<int16_t, int16_t>>(
+				inputFileName1, samplingRate);
+
+		Audio<pair<int16_t, int16_t>> audioFile2 = input2.get();
+
+		Audio<pair<int16_t, int16_t>> audio = audioFile1.crossfade(audioFile2,
+				overlap);
+
+		audio.saveAudioFile(outputFileName);
+
+	}
+
+}
+
+template<typename BitCount> void saveConverted(Audio<BitCount>& audioFile,
+		int targetBits, bool dither, string outputFileName) {
+
+	if (targetBits == 8) {
+
+		audioFile.template convertBitCount<int8_t>(dither).saveAudioFile(
+				outputFileName);
+
+	} else {
+
+		audioFile.template convertBitCount<int16_t>(dither).saveAudioFile(
+				outputFileName);
+
+	}
+
+}
+
+template<typename BitCount> void convertFile(int samplingRate,
+		int numChannels, string inputFileName, string outputFileName,
+		int targetBits, int targetChannels, pair<float, float> gains,
+		bool dither) {
+
+	if (numChannels == 1) {
+
+		Audio<BitCount> audioFile = Audio<BitCount>(inputFileName,
+				samplingRate);
+
+		if (targetChannels == 1) {
+
+			saveConverted(audioFile, targetBits, dither, outputFileName);
+
+		} else {
+
+			Audio<pair<BitCount, BitCount>> audio = audioFile.upmix();
+
+			saveConverted(audio, targetBits, dither, outputFileName);
+
+		}
+
+	} else {
+
+		Audio<pair<BitCount, BitCount>> audioFile = Audio<
+				pair<BitCount, BitCount>>(inputFileName, samplingRate);
+
+		if (targetChannels == 2) {
+
+			saveConverted(audioFile, targetBits, dither, outputFileName);
+
+		} else {
+
+			Audio<BitCount> audio = audioFile.downmix(gains);
+
+			saveConverted(audio, targetBits, dither, outputFileName);
+
+		}
+
+	}
+
+}
+
+void convert(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName, int targetBits,
+		int targetChannels, pair<float, float> gains, bool dither) {
+
+	if (bCount == 8) {
+
+		convertFile<int8_t>(samplingRate, numChannels, inputFileName,
+				outputFileName, targetBits, targetChannels, gains, dither);
+
+	} else {
+
+		convertFile<int16_t>(samplingRate, numChannels, inputFileName,
+				outputFileName, targetBits, targetChannels, gains, dither);
+
+	}
+
+}
+
+void stream(int samplingRate, int bCount, int numChannels, int blockFrames,
+		const vector<StreamOp>& ops) {
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			AudioStream<int8_t>(samplingRate, numChannels, blockFrames, ops).run(
+					stdin, stdout);
+
+		} else {
+
+			AudioStream<pair<int8_t, int8_t>>(samplingRate, numChannels,
+					blockFrames, ops).run(stdin, stdout);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			AudioStream<int16_t>(samplingRate, numChannels, blockFrames, ops).run(
+					stdin, stdout);
+
+		} else {
+
+			AudioStream<pair<int16_t, int16_t>>(samplingRate, numChannels,
+					blockFrames, ops).run(stdin, stdout);
+
+		}
+
+	}
+
+}
+
+void split(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string spec, string outputFileName) {
+
+	int frameBytes = bCount / 8 * numChannels;
+
+	struct stat fileInfo;
+
+	if (stat(inputFileName.c_str(), &fileInfo) != 0) {
+
+		cout << "Error: unable to open [.raw] file." << endl;
+
+		exit(1);
+
+	}
+
+	// segments are byte ranges of the input, which a .slac file does not have
+	if (isLosslessFile(inputFileName)) {
+
+		cout << "Error: -split only supports .raw files." << endl;
+
+		exit(1);
+
+	}
+
+	vector<pair<long, long>> segments = parseSegments(spec, samplingRate,
+			(long) fileInfo.st_size / frameBytes);
+
+	vector<string> outputFileNames;
+
+	for (int k = 0; k < segments.size(); ++k) {
+
+		outputFileNames.push_back(
+				outputFileName + "_" + to_string(k + 1) + "_"
+						+ to_string(samplingRate) + "_" + to_string(bCount)
+						+ (numChannels == 1 ? "_mono.raw" : "_stereo.raw"));
+
+	}
+
+	splitFile(inputFileName, segments, frameBytes, outputFileNames);
+
+	cout << "Segments written: " << segments.size() << endl;
+
+}
+
+// load a sound file as a single float signal (stereo is averaged)
+template<typename BitCount> vector<float> loadMonoSignal(string inputFileName,
+		int samplingRate, int numChannels) {
+
+	if (numChannels == 1) {
+
+		Audio<BitCount> audioFile = Audio<BitCount>(inputFileName, samplingRate);
+
+		return vector<float>(audioFile.getSamples().begin(),
+				audioFile.getSamples().end());
+
+	}
+
+	Audio<pair<BitCount, BitCount>> audioFile =
+			Audio<pair<BitCount, BitCount>>(inputFileName, samplingRate);
+
+	const vector<pair<BitCount, BitCount>>& s = audioFile.getSamples();
+
+	vector<float> x(s.size());
+
+	for (int k = 0; k < s.size(); ++k) {
+
+		x[k] = 0.5f * (s[k].first + s[k].second);
+
+	}
+
+	return x;
+
+}
+
+vector<float> loadMonoSignal(int samplingRate, int bCount, int numChannels,
+		string inputFileName) {
+
+	if (bCount == 8) {
+
+		return loadMonoSignal<int8_t>(inputFileName, samplingRate, numChannels);
+
+	}
+
+	return loadMonoSignal<int16_t>(inputFileName, samplingRate, numChannels);
+
+}
+
+void fingerprintIndex(int samplingRate, int bCount, int numChannels,
+		string indexFileName, const vector<string>& inputFileNames) {
+
+	FingerprintIndex index;
+
+	index.load(indexFileName);
+
+	for (int k = 0; k < inputFileNames.size(); ++k) {
+
+		vector<float> x = loadMonoSignal(samplingRate, bCount, numChannels,
+				inputFileNames[k]);
+
+		ScopedStage stage("fingerprint", x.size() * bCount / 8 * numChannels,
+				x.size());
+
+		float hopSeconds;
+
+		vector<uint32_t> prints = computeFingerprint(x, samplingRate,
+				hopSeconds);
+
+		index.add(inputFileNames[k], hopSeconds, prints);
+
+	}
+
+	index.commit();
+
+	index.save(indexFileName);
+
+	cout << "Files in index: " << index.size() << endl;
+
+}
+
+void fingerprintQuery(int samplingRate, int bCount, int numChannels,
+		string indexFileName, string inputFileName) {
+
+	FingerprintIndex index;
+
+	if (!index.load(indexFileName)) {
+
+		cout << "Error: unable to open index file." << endl;
+
+		exit(1);
+
+	}
+
+	vector<float> x = loadMonoSignal(samplingRate, bCount, numChannels,
+			inputFileName);
+
+	float hopSeconds;
+
+	vector<uint32_t> prints = computeFingerprint(x, samplingRate, hopSeconds);
+
+	vector<FingerprintIndex::Match> matches = index.query(prints);
+
+	cout << "Matches: " << matches.size() << endl;
+
+	for (int k = 0; k < matches.size(); ++k) {
+
+		cout << matches[k].name << " at " << matches[k].offsetSeconds
+				<< "s (bit error rate " << matches[k].bitErrorRate << ", "
+				<< matches[k].votes << " hits)" << endl;
+
+	}
+
+}
+
+template<typename BitCount> void alignMono(int samplingRate,
+		string inputFileName1, string inputFileName2, string outputFileName,
+		bool mix) {
+
+	future<Audio<BitCount>> input2 = loadAsync<BitCount>(inputFileName2,
+			samplingRate);
+
+	Audio<BitCount> audioFile1 = Audio<BitCount>(inputFileName1, samplingRate);
+
+	Audio<BitCount> audioFile2 = input2.get();
+
+	const vector<BitCount>& s1 = audioFile1.getSamples();
+
+	const vector<BitCount>& s2 = audioFile2.getSamples();
+
+	ScopedStage stage("align", (s1.size() + s2.size()) * sizeof(BitCount),
+			s1.size() + s2.size());
+
+	long lag = findLag(vector<float>(s1.begin(), s1.end()),
+			vector<float>(s2.begin(), s2.end()));
+
+	cout << "Offset: " << lag << " samples (" << lag / (float) samplingRate
+			<< "s)" << endl;
+
+	if (mix) {
+
+		Audio<BitCount> shifted = audioFile2.shifted(lag, (int) s1.size());
+
+		Audio<BitCount> audio = audioFile1 + shifted;
+
+		audio.saveAudioFile(outputFileName);
+
+	}
+
+}
+
+template<typename BitCount> void alignStereo(int samplingRate,
+		string inputFileName1, string inputFileName2, string outputFileName,
+		bool mix) {
+
+	future<Audio<pair<BitCount, BitCount>>> input2 = loadAsync<
+			pair<BitCount, BitCount>>(inputFileName2, samplingRate);
+
+	Audio<pair<BitCount, BitCount>> audioFile1 = Audio<pair<BitCount, BitCount>>(
+			inputFileName1, samplingRate);
+
+	Audio<pair<BitCount, BitCount>> audioFile2 = input2.get();
+
+	const vector<pair<BitCount, BitCount>>& s1 = audioFile1.getSamples();
+
+	const vector<pair<BitCount, BitCount>>& s2 = audioFile2.getSamples();
+
+	ScopedStage stage("align", (s1.size() + s2.size()) * sizeof(BitCount) * 2,
+			s1.size() + s2.size());
+
+	vector<float> left1(s1.size()), right1(s1.size()), left2(s2.size()),
+			right2(s2.size());
+
+	for (int k = 0; k < s1.size(); ++k) {
+
+		left1[k] = s1[k].first;
+
+		right1[k] = s1[k].second;
+
+	}
+
+	for (int k = 0; k < s2.size(); ++k) {
+
+		left2[k] = s2[k].first;
+
+		right2[k] = s2[k].second;
+
+	}
+
+	pair<long, long> lag = make_pair(findLag(left1, left2),
+			findLag(right1, right2));
+
+	cout << "Left channel offset: " << lag.first << " samples ("
+			<< lag.first / (float) samplingRate << "s)" << endl;
+
+	cout << "Right channel offset: " << lag.second << " samples ("
+			<< lag.second / (float) samplingRate << "s)" << endl;
+
+	if (mix) {
+
+		Audio<pair<BitCount, BitCount>> shifted = audioFile2.shifted(lag, (int) s1.size());
+
+		Audio<pair<BitCount, BitCount>> audio = audioFile1 + shifted;
+
+		audio.saveAudioFile(outputFileName);
+
+	}
+
+}
+
+void align(int samplingRate, int bCount, int numChannels,
+		string inputFileName1, string inputFileName2, string outputFileName,
+		bool mix) {
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			alignMono<int8_t>(samplingRate, inputFileName1, inputFileName2,
+					outputFileName, mix);
+
+		} else {
+
+			alignStereo<int8_t>(samplingRate, inputFileName1, inputFileName2,
+					outputFileName, mix);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			alignMono<int16_t>(samplingRate, inputFileName1, inputFileName2,
+					outputFileName, mix);
+
+		} else {
+
+			alignStereo<int16_t>(samplingRate, inputFileName1, inputFileName2,
+					outputFileName, mix);
+
+		}
+
+	}
+
+}
+
+/*Encode a sound file as .slac, then decode it back and report the compressed
+size, the ratio and the encode/decode throughput (the decoded samples are
+checked against the input).*/
+template<typename Frame> void encodeFile(int samplingRate, int bCount,
+		int numChannels, string inputFileName, string outputFileName) {
+
+	Audio<Frame> audioFile = Audio<Frame>(inputFileName, samplingRate);
+
+	string slacFileName = audioFileName(outputFileName, samplingRate, bCount,
+			numChannels) + ".slac";
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	losslessOutput() = true;
+
+	audioFile.saveAudioFile(outputFileName);
+
+	chrono::steady_clock::time_point encoded = chrono::steady_clock::now();
+
+	Audio<Frame> decoded = Audio<Frame>(slacFileName, samplingRate);
+
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+
+	double rawBytes = audioFile.getSamples().size() * (double) sizeof(Frame);
+
+	double slacBytes = decoded.getAudioFileSize(slacFileName);
+
+	double encodeSeconds = chrono::duration<double>(encoded - start).count();
+
+	double decodeSeconds = chrono::duration<double>(end - encoded).count();
+
+	cout << "Raw size: " << (long) rawBytes << " bytes" << endl;
+
+	cout << "Compressed size: " << (long) slacBytes << " bytes (ratio "
+			<< (slacBytes > 0 ? rawBytes / slacBytes : 0) << ")" << endl;
+
+	cout << "Encode: " << rawBytes / 1e6 / encodeSeconds << " MB/s" << endl;
+
+	cout << "Decode: " << rawBytes / 1e6 / decodeSeconds << " MB/s" << endl;
+
+	cout << "Lossless: "
+			<< (decoded.getSamples() == audioFile.getSamples() ? "yes" : "no")
+			<< endl;
+
+}
+
+void encode(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName) {
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			encodeFile<int8_t>(samplingRate, bCount, numChannels, inputFileName,
+					outputFileName);
+
+		} else {
+
+			encodeFile<pair<int8_t, int8_t>>(samplingRate, bCount, numChannels,
+					inputFileName, outputFileName);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			encodeFile<int16_t>(samplingRate, bCount, numChannels, inputFileName,
+					outputFileName);
+
+		} else {
+
+			encodeFile<pair<int16_t, int16_t>>(samplingRate, bCount, numChannels,
+					inputFileName, outputFileName);
+
+		}
+
+	}
+
+}
+
+// decode a .slac file back to .raw
+void decode(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName) {
+
+	losslessOutput() = false;
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			Audio<int8_t>(inputFileName, samplingRate).saveAudioFile(
+					outputFileName);
+
+		} else {
+
+			Audio<pair<int8_t, int8_t>>(inputFileName, samplingRate).saveAudioFile(
+					outputFileName);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			Audio<int16_t>(inputFileName, samplingRate).saveAudioFile(
+					outputFileName);
+
+		} else {
+
+			Audio<pair<int16_t, int16_t>>(inputFileName, samplingRate).saveAudioFile(
+					outputFileName);
+
+		}
+
+	}
+
+}
+
+// normalize a newly appended mono tail against the running rms
+template<typename BitCount> void normalizeTail(Audio<BitCount>& tail,
+		pair<float, float> level, const ProcessingState& state) {
+
+	tail.normalizeSound(level.first, state.rms(0));
+
+}
+
+// normalize a newly appended stereo tail against the running rms
+template<typename BitCount> void normalizeTail(
+		Audio<pair<BitCount, BitCount>>& tail, pair<float, float> level,
+		const ProcessingState& state) {
+
+	tail.normalizeSound(level, make_pair(state.rms(0), state.rms(1)));
+
+}
+
+/*Incremental -rms, -norm or -filter of a growing recording: only the frames
+appended since the last run are loaded and processed; the running sums and
+filter state come from (and go back to) the state file, and processed frames
+are appended to the existing output.*/
+template<typename Frame> void incrementalFile(int samplingRate,
+		int numChannels, string inputFileName, string outputFileName,
+		string stateFileName, string operation, pair<float, float> level,
+		string spec) {
+
+	stringstream job;
+
+	job << operation << " ";
+
+	if (operation == "-filter") {
+
+		job << spec;
+
+	} else if (operation == "-norm") {
+
+		job << level.first << " " << level.second;
+
+	}
+
+	job << " " << inputFileName;
+
+	// -norm and -filter append to their output file
+	string rawFileName = audioFileName(outputFileName, samplingRate,
+			sizeof(Frame) / numChannels * 8, numChannels) + ".raw";
+
+	bool writesOutput = operation != "-rms";
+
+	if (writesOutput) {
+
+		job << " -o " << outputFileName;
+
+	}
+
+	ProcessingState state;
+
+	if (state.load(stateFileName) && state.job != job.str()) {
+
+		cout << "Error: state file [" << stateFileName
+				<< "] belongs to a different job (" << state.job << ")." << endl;
+
+		exit(1);
+
+	}
+
+	// a .raw file shorter than what was processed has been replaced: start over
+	struct stat fileInfo;
+
+	if (!isLosslessFile(inputFileName)
+			&& stat(inputFileName.c_str(), &fileInfo) == 0
+			&& (long) fileInfo.st_size / (long) sizeof(Frame) < state.offset) {
+
+		state = ProcessingState();
+
+	}
+
+	/*The output has to hold exactly the frames processed so far. If it holds
+	more, the last run appended them but did not get to save its state: cut them
+	off and process them again. If it holds fewer, it was deleted or truncated:
+	start over.*/
+	if (writesOutput && state.offset > 0) {
+
+		long outputBytes =
+				stat(rawFileName.c_str(), &fileInfo) == 0 ?
+						(long) fileInfo.st_size : 0;
+
+		long expectedBytes = state.offset * (long) sizeof(Frame);
+
+		if (outputBytes < expectedBytes) {
+
+			state = ProcessingState();
+
+		} else if (outputBytes > expectedBytes
+				&& truncate(rawFileName.c_str(), expectedBytes) != 0) {
+
+			cout << "Error: unable to open [.raw] file." << endl;
+
+			exit(1);
+
+		}
+
+	}
+
+	state.job = job.str();
+
+	bool append = state.offset > 0;
+
+	Audio<Frame> tail = Audio<Frame>(inputFileName, samplingRate, state.offset);
+
+	state.accumulate(tail.getSamples(), numChannels);
+
+	cout << "New frames: " << tail.getSamples().size() << " (total "
+			<< state.offset << ")" << endl;
+
+	if (operation == "-rms") {
+
+		if (numChannels == 1) {
+
+			cout << "Audio file RMS: " << state.rms(0) << endl;
+
+		} else {
+
+			cout << "Audio file left channel RMS: " << state.rms(0) << endl;
+
+			cout << "Audio file right channel RMS: " << state.rms(1) << endl;
+
+		}
+
+	} else {
+
+		if (operation == "-norm") {
+
+			normalizeTail(tail, level, state);
+
+		} else {
+
+			BiquadChain chain = BiquadChain::parse(spec, samplingRate,
+					numChannels);
+
+			chain.setState(state.filterState);
+
+			tail.filter(chain);
+
+			state.filterState = chain.getState();
+
+		}
+
+		tail.saveAudioFile(outputFileName, append);
+
+	}
+
+	state.save(stateFileName);
+
+}
+
+void incremental(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName, string stateFileName,
+		string operation, pair<float, float> level, string spec) {
+
+	if (losslessOutput()) {
+
+		cout << "Error: --state appends to .raw output (not --slac)." << endl;
+
+		exit(1);
+
+	}
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			incrementalFile<int8_t>(samplingRate, numChannels, inputFileName,
+					outputFileName, stateFileName, operation, level, spec);
+
+		} else {
+
+			incrementalFile<pair<int8_t, int8_t>>(samplingRate, numChannels,
+					inputFileName, outputFileName, stateFileName, operation, level,
+					spec);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			incrementalFile<int16_t>(samplingRate, numChannels, inputFileName,
+					outputFileName, stateFileName, operation, level, spec);
+
+		} else {
+
+			incrementalFile<pair<int16_t, int16_t>>(samplingRate, numChannels,
+					inputFileName, outputFileName, stateFileName, operation, level,
+					spec);
+
+		}
+
+	}
+
+}
+
+// STFT spectrogram of a sound file (stereo is averaged) as .pgm, .ppm or .bin
+void spectrogram(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName, int size, int hop,
+		string window, string scale, string format) {
+
+	if (size < 4 || (size & (size - 1)) != 0 || hop <= 0) {
+
+		cout << "Error: window size must be a power of two and hop positive."
+				<< endl;
+
+		exit(1);
+
+	}
+
+	vector<float> x = loadMonoSignal(samplingRate, bCount, numChannels,
+			inputFileName);
+
+	ScopedStage stage("spectrogram", x.size() * bCount / 8 * numChannels,
+			x.size());
+
+	Spectrogram spec(x, samplingRate, size, hop, window, scale);
+
+	string fileName = outputFileName + "." + format;
+
+	if (format == "bin") {
+
+		spec.writeMatrix(fileName);
+
+	} else if (format == "pgm" || format == "ppm") {
+
+		spec.writeImage(fileName, format == "ppm");
+
+	} else {
+
+		cout << "Error: unknown spectrogram format [" << format << "]." << endl;
+
+		exit(1);
+
+	}
+
+	noteWrittenFile(fileName);
+
+	cout << "Spectrogram: " << spec.numCols() << " frames x "
+			<< spec.numRows() << " rows written to " << fileName << endl;
+
+}
+
+/*QA metrics of a sound file in one pass (see Analysis.h), printed as JSON and
+saved to <outFileName>.json.*/
+template<typename Frame> void audioStatsFile(int samplingRate,
+		int bCount, int numChannels, string inputFileName,
+		string outputFileName, int bins) {
+
+	if (bins < 1 || bins > (1 << bCount)) {
+
+		cout << "Error: histogram bins must be between 1 and " << (1 << bCount)
+				<< "." << endl;
+
+		exit(1);
+
+	}
+
+	Audio<Frame> audioFile = Audio<Frame>(inputFileName, samplingRate);
+
+	const vector<Frame>& samples = audioFile.getSamples();
+
+	vector<ChannelStats> stats;
+
+	{
+
+		ScopedStage stage("stats", samples.size() * sizeof(Frame),
+				samples.size());
+
+		stats = analyze(samples, numChannels, bCount, bins);
+
+	}
+
+	ofstream oFile(outputFileName + ".json");
+
+	if (!oFile.is_open()) {
+
+		cout << "Error: unable to write [.json] file." << endl;
+
+		exit(1);
+
+	}
+
+	noteWrittenFile(outputFileName + ".json");
+
+	writeStatsJson(oFile, stats, samples.size(), samplingRate, bCount);
+
+	writeStatsJson(cout, stats, samples.size(), samplingRate, bCount);
+
+}
+
+void audioStats(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName, int bins) {
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			audioStatsFile<int8_t>(samplingRate, bCount, numChannels,
+					inputFileName, outputFileName, bins);
+
+		} else {
+
+			audioStatsFile<pair<int8_t, int8_t>>(samplingRate, bCount, numChannels,
+					inputFileName, outputFileName, bins);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			audioStatsFile<int16_t>(samplingRate, bCount, numChannels,
+					inputFileName, outputFileName, bins);
+
+		} else {
+
+			audioStatsFile<pair<int16_t, int16_t>>(samplingRate, bCount, numChannels,
+					inputFileName, outputFileName, bins);
+
+		}
+
+	}
+
+}
+
+/*Gain envelope: the keyframes of spec (see GainEnvelope::parse) or, for an empty
+spec, a fade in over the first fades.first and out over the last fades.second
+seconds, applied in place in one pass.*/
+template<typename Frame> void envelopeFile(int samplingRate,
+		string inputFileName, string outputFileName, string spec,
+		pair<float, float> fades, bool exponential) {
+
+	Audio<Frame> audioFile = Audio<Frame>(inputFileName, samplingRate);
+
+	long length = (long) audioFile.getSamples().size();
+
+	GainEnvelope env =
+			spec.empty() ?
+					GainEnvelope::fades(length, lround(fades.first * samplingRate),
+							lround(fades.second * samplingRate), exponential) :
+					GainEnvelope::parse(spec, samplingRate, exponential);
+
+	audioFile.envelope(env).saveAudioFile(outputFileName);
+
+}
+
+void envelope(int samplingRate, int bCount, int numChannels,
+		string inputFileName, string outputFileName, string spec,
+		pair<float, float> fades, bool exponential) {
+
+	if (bCount == 8) {
+
+		if (numChannels == 1) {
+
+			envelopeFile<int8_t>(samplingRate, inputFileName, outputFileName, spec,
+					fades, exponential);
+
+		} else {
+
+			envelopeFile<pair<int8_t, int8_t>>(samplingRate, inputFileName,
+					outputFileName, spec, fades, exponential);
+
+		}
+
+	} else {
+
+		if (numChannels == 1) {
+
+			envelopeFile<int16_t>(samplingRate, inputFileName, outputFileName, spec,
+					fades, exponential);
+
+		} else {
+
+			envelopeFile<pair<int16_t, int16_t>>(samplingRate, inputFileName,
+					outputFileName, spec, fades, exponential);
+
+		}
+
+	}
+
+}
+
+/*Render an edit list over the master sound file (see EditList.h) into
+<out>_<rate>_<bits>_<layout>.raw in one streaming pass over the sources.*/
+void editList(int samplingRate, int bCount, int numChannels,
+		string editListFileName, string inputFileName, string outputFileName) {
+
+	if (losslessOutput()) {
+
+		cout << "Error: -edl renders .raw files only." << endl;
+
+		exit(1);
+
+	}
+
+	EditList edl(editListFileName, inputFileName, samplingRate,
+			bCount / 8 * numChannels);
+
+	string rawFileName = audioFileName(outputFileName, samplingRate, bCount,
+			numChannels) + ".raw";
+
+	if (bCount == 8) {
+
+		edl.render<int8_t>(rawFileName);
+
+	} else {
+
+		edl.render<int16_t>(rawFileName);
+
+	}
+
+	cout << "Segments: " << edl.numSegments() << endl;
+
+	cout << "Output length: " << edl.outputFrames() / (double) samplingRate
+			<< " seconds" << endl;
+
+}
+
+int processIntVal(char* val) {
+
+	stringstream ss(val);
+
+	int value;
+
+	ss >> value;
+
+	return value;
+
+}
+
+float processFloatVal(char* val) {
+
+	stringstream ss(val);
+
+	float value;
+
+	ss >> value;
+
+	return value;
+
+}
+
+/*Operations on quad, 5.1 and 7.1 files (-c 4, 6 or 8), all through the generic
+N-channel Audio class. Per-channel arguments (-v, -norm) take one value per
+channel, and -xfade takes one overlap for every channel.*/
+template<typename BitCount, size_t N> void multichannelFile(int samplingRate,
+		char* argv[], int position, string operation, string outputFileName) {
+
+	typedef Audio<Frame<BitCount, N>> AudioN;
+
+	if (operation == "-add" || operation == "-cat") {
+
+		future<AudioN> input2 = loadAsync<Frame<BitCount, N>>(
+				argv[position + 2], samplingRate);
+
+		AudioN audioFile1 = AudioN(argv[position + 1], samplingRate);
+
+		AudioN audioFile2 = input2.get();
+
+		AudioN audio = operation == "-add" ?
+				AudioN(audioFile1 + audioFile2) : audioFile1 | audioFile2;
+
+		audio.saveAudioFile(outputFileName);
+
+	} else if (operation == "-cut") {
+
+		int r1 = processIntVal(argv[++position]);
+
+		int r2 = processIntVal(argv[++position]);
+
+		string inputFileName = argv[++position];
+
+		AudioN audioFirst = AudioN(inputFileName, samplingRate, 0, r1);
+
+		AudioN audioSecond = AudioN(inputFileName, samplingRate, r2 + 1);
+
+		AudioN audio = audioFirst | audioSecond;
+
+		audio.saveAudioFile(outputFileName);
+
+	} else if (operation == "-radd") {
+
+		int r1 = processIntVal(argv[++position]);
+
+		int r2 = processIntVal(argv[++position]);
+
+		future<AudioN> input2 = loadAsync<Frame<BitCount, N>>(
+				argv[position + 2], samplingRate);
+
+		AudioN audioFile1 = AudioN(argv[position + 1], samplingRate);
+
+		AudioN audioFile2 = input2.get();
+
+		audioFile1.rangedAdd(audioFile2, make_pair(r1, r2)).saveAudioFile(
+				outputFileName);
+
+	} else if (operation == "-xfade") {
+
+		int overlap = (int) (processFloatVal(argv[++position]) * samplingRate);
+
+		future<AudioN> input2 = loadAsync<Frame<BitCount, N>>(
+				argv[position + 2], samplingRate);
+
+		AudioN audioFile1 = AudioN(argv[position + 1], samplingRate);
+
+		AudioN audioFile2 = input2.get();
+
+		audioFile1.crossfade(audioFile2, overlap).saveAudioFile(outputFileName);
+
+	} else if (operation == "-v" || operation == "-norm") {
+
+		array<float, N> values;
+
+		for (size_t c = 0; c < N; ++c) {
+
+			values[c] = processFloatVal(argv[++position]);
+
+		}
+
+		AudioN audioFile = AudioN(argv[++position], samplingRate, 0, -1,
+				operation == "-norm");
+
+		if (operation == "-v") {
+
+			AudioN audio = audioFile * values;
+
+			audio.saveAudioFile(outputFileName);
+
+		} else {
+
+			audioFile.normalizeSound(values).saveAudioFile(outputFileName);
+
+		}
+
+	} else if (operation == "-rev") {
+
+		AudioN audioFile = AudioN(argv[++position], samplingRate);
+
+		audioFile.revOrdering();
+
+		audioFile.saveAudioFile(outputFileName);
+
+	} else if (operation == "-rms") {
+
+		array<float, N> rms = AudioN(argv[++position], samplingRate, 0, -1,
+				true).computeRMS();
+
+		for (size_t c = 0; c < N; ++c) {
+
+			cout << "Audio file channel " << c + 1 << " RMS: " << rms[c] << endl;
+
+		}
+
+	} else if (operation == "-filter") {
+
+		BiquadChain chain = BiquadChain::parse(argv[++position], samplingRate,
+				(int) N);
+
+		AudioN audioFile = AudioN(argv[++position], samplingRate);
+
+		audioFile.filter(chain).saveAudioFile(outputFileName);
+
+	} else if (operation == "-compress" || operation == "-limit") {
+
+		float thresholdDb = processFloatVal(argv[++position]);
+
+		float ratio = operation == "-limit" ?
+				INFINITY : processFloatVal(argv[++position]);
+
+		float attackMs = operation == "-limit" ?
+				0.0f : processFloatVal(argv[++position]);
+
+		float releaseMs = processFloatVal(argv[++position]);
+
+		float lookaheadMs = processFloatVal(argv[++position]);
+
+		Compressor compressor = operation == "-limit" ?
+				Compressor::limiter(thresholdDb, releaseMs, lookaheadMs,
+						samplingRate) :
+				Compressor(thresholdDb, ratio, attackMs, releaseMs, lookaheadMs,
+						samplingRate);
+
+		bool linked = true;
+
+		if (string(argv[position + 1]) == "-unlinked") {
+
+			linked = false;
+
+			++position;
+
+		}
+
+		AudioN audioFile = AudioN(argv[++position], samplingRate);
+
+		audioFile.compress(compressor, linked).saveAudioFile(outputFileName);
+
+	} else if (operation == "-stats") {
+
+		int bins = 32;
+
+		if (string(argv[position + 1]) == "-bins") {
+
+			bins = processIntVal(argv[position + 2]);
+
+			position += 2;
+
+		}
+
+		audioStatsFile<Frame<BitCount, N>>(samplingRate, sizeof(BitCount) * 8,
+				(int) N, argv[++position], outputFileName, bins);
+
+	} else if (operation == "-fade" || operation == "-envelope") {
+
+		bool exponential = string(argv[position + 1]) == "-exp";
+
+		position += exponential ? 1 : 0;
+
+		string spec;
+
+		pair<float, float> fades;
+
+		if (operation == "-fade") {
+
+			fades.first = processFloatVal(argv[++position]);
+
+			fades.second = processFloatVal(argv[++position]);
+
+		} else {
+
+			spec = argv[++position];
+
+		}
+
+		envelopeFile<Frame<BitCount, N>>(samplingRate, argv[++position],
+				outputFileName, spec, fades, exponential);
+
+	} else if (operation == "-edl") {
+
+		string editListFileName = argv[++position];
+
+		editList(samplingRate, sizeof(BitCount) * 8, (int) N, editListFileName,
+				argv[++position], outputFileName);
+
+	} else if (operation == "-encode") {
+
+		encodeFile<Frame<BitCount, N>>(samplingRate, sizeof(BitCount) * 8,
+				(int) N, argv[++position], outputFileName);
+
+	} else if (operation == "-decode") {
+
+		losslessOutput() = false;
+
+		AudioN(argv[++position], samplingRate).saveAudioFile(outputFileName);
+
+	} else {
+
+		cout << "Error: " << operation << " is not supported for " << N
+				<< "-channel files." << endl;
+
+		exit(1);
+
+	}
+
+}
+
+void multichannel(int samplingRate, int bCount, int numChannels, char* argv[],
+		int position, string operation, string outputFileName) {
+
+	if (bCount == 8) {
+
+		if (numChannels == 4) {
+
+			multichannelFile<int8_t, 4>(samplingRate, argv, position, operation,
+					outputFileName);
+
+		} else if (numChannels == 6) {
+
+			multichannelFile<int8_t, 6>(samplingRate, argv, position, operation,
+					outputFileName);
+
+		} else {
+
+			multichannelFile<int8_t, 8>(samplingRate, argv, position, operation,
+					outputFileName);
+
+		}
+
+	} else {
+
+		if (numChannels == 4) {
+
+			multichannelFile<int16_t, 4>(samplingRate, argv, position, operation,
+					outputFileName);
+
+		} else if (numChannels == 6) {
+
+			multichannelFile<int16_t, 6>(samplingRate, argv, position, operation,
+					outputFileName);
+
+		} else {
+
+			multichannelFile<int16_t, 8>(samplingRate, argv, position, operation,
+					outputFileName);
+
+		}
+
+	}
 
 }
 
@@ -0,0 +1,156 @@
+//=================================================================================
+// Name        : Dynamics.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Lookahead compressor / limiter gain computer with a sliding-window
+// 				 peak detector (monotonic deque, O(1) per sample)
+//=================================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <utility>
+
+#ifndef LIBS_DYNAMICS_H
+#define LIBS_DYNAMICS_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// Compressor class
+/*Produces one gain per sample. The detector level of sample k is the peak of
+the next `lookahead` samples (levels are in full-scale units, 1.0 = the largest
+sample value); a monotonic deque of (index, level) pairs keeps that window max
+in O(1) amortised time per sample (the deque is a ring buffer sized to the
+window, so processing does not allocate). Above the threshold the target gain reduces
+the level by the ratio (an infinite ratio limits), and the gain follows the
+target with one-pole attack / release smoothing. Because the detector sees the
+peak `lookahead` samples early, the gain has already come down when it arrives.
+A limiter additionally never lets a sample through above the threshold.
+
+Gains are generated block by block for increasing positions, so the state
+(window, gain) carries over between calls on the same signal.*/
+class Compressor {
+
+private:
+
+	float threshold, ratio, attack, release;
+
+	long lookahead;
+
+	bool limit;
+
+	vector<pair<long, float>> window;
+
+	long head, tail, next;
+
+	float gain;
+
+	// one-pole smoothing coefficient for a time constant of `samples`
+	static float coefficient(double samples) {
+
+		return samples > 0 ? (float) exp(-1.0 / samples) : 0.0f;
+
+	}
+
+	long forward(long i) const {
+
+		return i + 1 == (long) window.size() ? 0 : i + 1;
+
+	}
+
+	long back(long i) const {
+
+		return i == 0 ? window.size() - 1 : i - 1;
+
+	}
+
+	float targetGain(float level) const {
+
+		if (level <= threshold) {
+
+			return 1.0f;
+
+		}
+
+		return limit ? threshold / level :
+				(float) pow(level / threshold, 1.0 / ratio - 1.0);
+
+	}
+
+public:
+
+	// CONSTRUCTOR (thresholdDb in dB relative to full scale)
+	Compressor(float thresholdDb, float r, float attackMs, float releaseMs,
+			float lookaheadMs, int samplingRate) :
+			threshold((float) pow(10.0, thresholdDb / 20.0)), ratio(r), attack(
+					coefficient(attackMs * 0.001 * samplingRate)), release(
+					coefficient(releaseMs * 0.001 * samplingRate)), lookahead(
+					(long) (lookaheadMs * 0.001 * samplingRate)), limit(
+					isinf(r)), head(0), tail(0), next(0), gain(1.0f) {
+
+		window.resize(lookahead + 2);
+
+	}
+
+	/*Limiter: infinite ratio, with the attack spread over the lookahead window
+	(time constant of a fifth of it, so the gain is within 1% of its target when
+	the peak arrives).*/
+	static Compressor limiter(float thresholdDb, float releaseMs,
+			float lookaheadMs, int samplingRate) {
+
+		return Compressor(thresholdDb, INFINITY, lookaheadMs / 5, releaseMs,
+				lookaheadMs, samplingRate);
+
+	}
+
+	/*Gains for samples [first, first + n) of a signal numSamples long, where
+	level(k) returns the detector level of sample k (e.g. |x[k]| / full scale, or
+	the louder channel for linked stereo).*/
+	template<typename Level> void gains(long first, int n, long numSamples,
+			Level level, float* g) {
+
+		for (int j = 0; j < n; ++j) {
+
+			long k = first + j;
+
+			long end = min(k + lookahead, numSamples - 1);
+
+			for (; next <= end; ++next) {
+
+				float v = level(next);
+
+				while (tail != head && window[back(tail)].second <= v) {
+
+					tail = back(tail);
+
+				}
+
+				window[tail] = make_pair(next, v);
+
+				tail = forward(tail);
+
+			}
+
+			while (window[head].first < k) {
+
+				head = forward(head);
+
+			}
+
+			float target = targetGain(window[head].second);
+
+			gain = target + (gain - target) * (target < gain ? attack : release);
+
+			g[j] = limit ? min(gain, targetGain(level(k))) : gain;
+
+		}
+
+	}
+
+};
+
+}
+
+#endif
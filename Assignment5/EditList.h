@@ -0,0 +1,544 @@
+//=================================================================================
+// Name        : EditList.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Edit decision lists (-edl): cuts, inserts, ranged gains and ranged
+// 				 adds resolved into output segments and rendered in one pass
+//=================================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Audio.h"
+
+#ifndef LIBS_EDITLIST_H
+#define LIBS_EDITLIST_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// Edit struct: one line of an edit list, with times converted to master frames
+struct Edit {
+
+	string type;
+
+	long start, end;
+
+	int source;
+
+	long from;
+
+	float gain;
+
+};
+
+// EdlSegment struct: a run of output frames copied from one source
+struct EdlSegment {
+
+	int source;
+
+	long first, last;
+
+	float gain;
+
+	// (source, frame of that source mixed onto frame `first`) per ranged add
+	vector<pair<int, long>> adds;
+
+};
+
+// EditList class
+/*An edit list over a master recording, one edit per line (times in seconds of
+the master; '#' starts a comment):
+
+	cut start end                   remove the master over [start, end)
+	gain start end factor           scale the master over [start, end)
+	insert at file [from to]        insert (part of) file at master time `at`
+	add at file [from to]           mix (part of) file onto the master from `at`
+
+All edits refer to the master's own timeline, so their order in the list only
+matters for inserts at the same time (they follow list order). The list is
+resolved once into sorted output segments: every edit boundary becomes a
+breakpoint, and a sweep over the breakpoints keeps the set of active cuts,
+gains and adds, so each master interval between breakpoints becomes at most
+one segment (none if cut) carrying its combined gain and the adds that cover
+it; inserts become segments of their own source. Rendering then streams the
+segments to the output with ranged reads, so the work is proportional to the
+output length, not to the number of edits times the file length. Sources are
+.raw files of the master's format; gains and adds saturate.*/
+class EditList {
+
+private:
+
+	vector<string> sources;
+
+	vector<long> lengths;
+
+	vector<EdlSegment> segments;
+
+	int frameBytes;
+
+	static void fail(int lineNumber, const string& message) {
+
+		cout << "Error: edit list line " << lineNumber << ": " << message << "."
+				<< endl;
+
+		exit(1);
+
+	}
+
+	int sourceIndex(const string& fileName, int lineNumber) {
+
+		for (int k = 0; k < sources.size(); ++k) {
+
+			if (sources[k] == fileName) {
+
+				return k;
+
+			}
+
+		}
+
+		struct stat info;
+
+		if (stat(fileName.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+
+			fail(lineNumber, "cannot open [" + fileName + "]");
+
+		}
+
+		if (isLosslessFile(fileName)) {
+
+			fail(lineNumber, "sources must be .raw files");
+
+		}
+
+		sources.push_back(fileName);
+
+		lengths.push_back((long) info.st_size / frameBytes);
+
+		return (int) sources.size() - 1;
+
+	}
+
+	// frames [first, first + n) of a source (zeros past its end)
+	void readFrames(int fd, long first, int n, char* buffer) const {
+
+		size_t want = (size_t) n * frameBytes, got = 0;
+
+		while (got < want) {
+
+			ssize_t r = pread(fd, buffer + got, want - got,
+					(off_t) first * frameBytes + got);
+
+			if (r <= 0) {
+
+				break;
+
+			}
+
+			got += r;
+
+		}
+
+		memset(buffer + got, 0, want - got);
+
+	}
+
+	void resolve(vector<Edit>& edits, const vector<Edit>& inserts) {
+
+		long masterLength = lengths[0];
+
+		vector<long> points;
+
+		points.push_back(0);
+
+		points.push_back(masterLength);
+
+		for (int k = 0; k < edits.size(); ++k) {
+
+			points.push_back(edits[k].start);
+
+			points.push_back(edits[k].end);
+
+		}
+
+		for (int k = 0; k < inserts.size(); ++k) {
+
+			points.push_back(inserts[k].start);
+
+		}
+
+		sort(points.begin(), points.end());
+
+		points.erase(unique(points.begin(), points.end()), points.end());
+
+		stable_sort(edits.begin(), edits.end(), [](const Edit& a, const Edit& b) {
+
+			return a.start < b.start;
+
+		});
+
+		vector<const Edit*> active;
+
+		int nextEdit = 0, nextInsert = 0;
+
+		for (int p = 0; p < points.size(); ++p) {
+
+			long first = points[p];
+
+			for (; nextInsert < inserts.size()
+					&& inserts[nextInsert].start == first; ++nextInsert) {
+
+				const Edit& e = inserts[nextInsert];
+
+				EdlSegment s = { e.source, e.from, e.end, 1.0f };
+
+				segments.push_back(s);
+
+			}
+
+			if (first >= masterLength) {
+
+				break;
+
+			}
+
+			long last = points[p + 1];
+
+			active.erase(remove_if(active.begin(), active.end(),
+					[first](const Edit* e) {return e->end <= first;}), active.end());
+
+			for (; nextEdit < edits.size() && edits[nextEdit].start <= first;
+					++nextEdit) {
+
+				if (edits[nextEdit].end > first) {
+
+					active.push_back(&edits[nextEdit]);
+
+				}
+
+			}
+
+			EdlSegment s = { 0, first, last, 1.0f };
+
+			bool cut = false;
+
+			for (int k = 0; k < active.size(); ++k) {
+
+				const Edit& e = *active[k];
+
+				if (e.type == "cut") {
+
+					cut = true;
+
+				} else if (e.type == "gain") {
+
+					s.gain *= e.gain;
+
+				} else {
+
+					s.adds.push_back(make_pair(e.source, e.from + (first - e.start)));
+
+				}
+
+			}
+
+			if (!cut) {
+
+				segments.push_back(s);
+
+			}
+
+		}
+
+	}
+
+public:
+
+	// CONSTRUCTOR (parse and resolve the edit list against the master recording)
+	EditList(const string& fileName, const string& masterFileName,
+			int samplingRate, int fBytes) :
+			frameBytes(fBytes) {
+
+		ScopedStage stage("edlResolve");
+
+		ifstream iFile(fileName);
+
+		if (!iFile.is_open()) {
+
+			cout << "Error: unable to open edit list." << endl;
+
+			exit(1);
+
+		}
+
+		sourceIndex(masterFileName, 0);
+
+		long masterLength = lengths[0];
+
+		vector<Edit> edits, inserts;
+
+		string line;
+
+		int lineNumber = 0;
+
+		while (getline(iFile, line)) {
+
+			++lineNumber;
+
+			line = line.substr(0, line.find('#'));
+
+			stringstream fields(line);
+
+			Edit e;
+
+			double start, end = 0.0;
+
+			if (!(fields >> e.type)) {
+
+				continue;
+
+			}
+
+			if (!(fields >> start) || start < 0) {
+
+				fail(lineNumber, "missing or negative time");
+
+			}
+
+			e.start = min(masterLength, (long) llround(start * samplingRate));
+
+			e.source = 0;
+
+			e.from = 0;
+
+			e.gain = 1.0f;
+
+			if (e.type == "cut" || e.type == "gain") {
+
+				if (!(fields >> end) || end < start) {
+
+					fail(lineNumber, "missing or reversed end time");
+
+				}
+
+				e.end = min(masterLength, (long) llround(end * samplingRate));
+
+				if (e.type == "gain" && !(fields >> e.gain)) {
+
+					fail(lineNumber, "missing gain factor");
+
+				}
+
+				edits.push_back(e);
+
+			} else if (e.type == "insert" || e.type == "add") {
+
+				string source;
+
+				if (!(fields >> source)) {
+
+					fail(lineNumber, "missing source file");
+
+				}
+
+				e.source = sourceIndex(source, lineNumber);
+
+				long length = lengths[e.source];
+
+				double from = 0.0, to = -1.0;
+
+				if (fields >> from >> to) {
+
+					if (from < 0 || to < from) {
+
+						fail(lineNumber, "invalid source range");
+
+					}
+
+					length = min(length, (long) llround(to * samplingRate));
+
+				}
+
+				e.from = min(length, (long) llround(from * samplingRate));
+
+				if (e.type == "insert") {
+
+					e.end = length;
+
+					inserts.push_back(e);
+
+				} else {
+
+					e.end = min(masterLength, e.start + (length - e.from));
+
+					edits.push_back(e);
+
+				}
+
+			} else {
+
+				fail(lineNumber, "unknown edit [" + e.type + "]");
+
+			}
+
+		}
+
+		stable_sort(inserts.begin(), inserts.end(),
+				[](const Edit& a, const Edit& b) {return a.start < b.start;});
+
+		resolve(edits, inserts);
+
+	}
+
+	long outputFrames() const {
+
+		long total = 0;
+
+		for (int k = 0; k < segments.size(); ++k) {
+
+			total += segments[k].last - segments[k].first;
+
+		}
+
+		return total;
+
+	}
+
+	int numSegments() const {
+
+		return (int) segments.size();
+
+	}
+
+	/*Render the segments in order into outputFileName, one block at a time:
+	each block is read from its source, scaled by the segment gain and mixed
+	with the blocks of its adds before it is written. The render goes to a
+	temporary file next to the output that is renamed over it at the end, so an
+	output that is also one of the sources is read intact.*/
+	template<typename BitCount> void render(const string& outputFileName) const {
+
+		long total = outputFrames();
+
+		ScopedStage stage("edlRender", total * frameBytes,
+				total * frameBytes / sizeof(BitCount));
+
+		vector<int> fds(sources.size());
+
+		for (int k = 0; k < sources.size(); ++k) {
+
+			fds[k] = open(sources[k].c_str(), O_RDONLY);
+
+		}
+
+		string tempFileName = outputFileName + ".tmp";
+
+		int outFd = open(tempFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+				0644);
+
+		if (outFd < 0) {
+
+			cout << "Error: unable to open [.raw] file." << endl;
+
+			exit(1);
+
+		}
+
+		const int low = numeric_limits < BitCount >::min();
+
+		const int high = numeric_limits < BitCount >::max();
+
+		int samplesPerFrame = frameBytes / sizeof(BitCount);
+
+		vector<BitCount> block((size_t) BLOCK_FRAMES * samplesPerFrame), other(
+				block.size());
+
+		for (int s = 0; s < segments.size(); ++s) {
+
+			const EdlSegment& seg = segments[s];
+
+			for (long pos = seg.first; pos < seg.last; pos += BLOCK_FRAMES) {
+
+				int n = (int) min((long) BLOCK_FRAMES, seg.last - pos);
+
+				int count = n * samplesPerFrame;
+
+				readFrames(fds[seg.source], pos, n, (char *) block.data());
+
+				if (seg.gain != 1.0f) {
+
+					for (int k = 0; k < count; ++k) {
+
+						block[k] = saturate<BitCount>(block[k] * seg.gain);
+
+					}
+
+				}
+
+				for (int a = 0; a < seg.adds.size(); ++a) {
+
+					readFrames(fds[seg.adds[a].first],
+							seg.adds[a].second + (pos - seg.first), n,
+							(char *) other.data());
+
+					for (int k = 0; k < count; ++k) {
+
+						int v = block[k] + other[k];
+
+						block[k] = (BitCount) min(high, max(low, v));
+
+					}
+
+				}
+
+				if (write(outFd, block.data(), (size_t) count * sizeof(BitCount))
+						!= (ssize_t) (count * sizeof(BitCount))) {
+
+					cout << "Error: unable to write [.raw] file." << endl;
+
+					unlink(tempFileName.c_str());
+
+					exit(1);
+
+				}
+
+			}
+
+		}
+
+		if (close(outFd) != 0
+				|| rename(tempFileName.c_str(), outputFileName.c_str()) != 0) {
+
+			cout << "Error: unable to write [.raw] file." << endl;
+
+			unlink(tempFileName.c_str());
+
+			exit(1);
+
+		}
+
+		for (int k = 0; k < fds.size(); ++k) {
+
+			close(fds[k]);
+
+		}
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,259 @@
+//=================================================================================
+// Name        : Expression.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Expression templates for the element-wise Audio operators, so a
+// 				 chain like (A + B) * F is evaluated in one loop on assignment
+//=================================================================================
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "Frame.h"
+
+#ifndef LIBS_EXPRESSION_H
+#define LIBS_EXPRESSION_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+template<typename BitCount> class Audio;
+
+template<typename L, typename R> class SumExpression;
+
+template<typename E, typename F> class ScaleExpression;
+
+// per-sample A + B (wraps to the sample type like the original operator+)
+template<typename S> inline S addSample(const S& a, const S& b) {
+
+	typedef typename FrameTraits<S>::sample_type BitCount;
+
+	S s;
+
+	forEachChannel<FrameTraits<S>::channels>([&](size_t c) {
+
+		channelSample(s, c) = (BitCount) (channelSample(a, c) + channelSample(b, c));
+
+	});
+
+	return s;
+
+}
+
+/*per-sample A * F, with one factor per channel in the same layout (truncates to
+the sample type like the original operator*)*/
+template<typename S, typename F> inline S scaleSample(const S& b, const F& vol) {
+
+	typedef typename FrameTraits<S>::sample_type BitCount;
+
+	S s;
+
+	forEachChannel<FrameTraits<S>::channels>([&](size_t c) {
+
+		channelSample(s, c) = (BitCount) (channelSample(b, c) * channelSample(vol, c));
+
+	});
+
+	return s;
+
+}
+
+/*Operands of an expression node: an Audio is held by reference (it owns the
+samples), any other node by value (it is only a few pointers and factors). So a
+temporary Audio cannot be an operand: in auto e = a + Audio<T>(...); it would
+be destroyed before e is evaluated. The operators reject one at compile time.*/
+template<typename E> struct ExpressionOperand {
+
+	typedef const E type;
+
+	static const bool isAudio = false;
+
+};
+
+template<typename BitCount> struct ExpressionOperand<Audio<BitCount>> {
+
+	typedef const Audio<BitCount>& type;
+
+	static const bool isAudio = true;
+
+};
+
+/*Evaluate an expression into out in a single loop. When the size is unchanged
+the samples are written in place, which is safe even if out is an operand:
+sample k only reads sample k of every operand.*/
+template<typename T, typename E> void evaluateExpression(const E& e,
+		vector<T>& out) {
+
+	long n = e.size();
+
+	if (n != (long) out.size()) {
+
+		vector<T> b(n);
+
+		for (long k = 0; k < n; ++k) {
+
+			b[k] = e[k];
+
+		}
+
+		out.swap(b);
+
+		return;
+
+	}
+
+	T* p = out.data();
+
+	for (long k = 0; k < n; ++k) {
+
+		p[k] = e[k];
+
+	}
+
+}
+
+// AudioExpression class
+/*Base of Audio and of the expression nodes (CRTP). A + B and A * F build nodes
+instead of Audio temporaries; nothing is computed until the expression is
+assigned to an Audio (or saved), which runs one loop over the samples that
+evaluates the whole tree per sample, with no intermediate buffers.*/
+template<typename Derived> class AudioExpression {
+
+public:
+
+	const Derived& self() const {
+
+		return static_cast<const Derived&>(*this);
+
+	}
+
+	// A+B: add sound file amplitudes together (per sample)
+	template<typename R> SumExpression<Derived, R> operator +(
+			const AudioExpression<R>& oAudio) const & {
+
+		return SumExpression<Derived, R>(self(), oAudio.self());
+
+	}
+
+	template<typename R> SumExpression<Derived, R> operator +(
+			const AudioExpression<R>& oAudio) && {
+
+		static_assert(!ExpressionOperand<Derived>::isAudio,
+				"a temporary Audio cannot be an operand: name it first");
+
+		return SumExpression<Derived, R>(self(), oAudio.self());
+
+	}
+
+	template<typename BitCount> void operator +(Audio<BitCount>&& oAudio) const & = delete;
+
+	template<typename BitCount> void operator +(Audio<BitCount>&& oAudio) && = delete;
+
+	/*A * F: volume factor A with F (a float for mono, a std::pair<float,float>
+	for stereo, a std::array<float, N> for N channels)*/
+	template<typename F> ScaleExpression<Derived, F> operator *(F vol) const & {
+
+		return ScaleExpression<Derived, F>(self(), vol);
+
+	}
+
+	template<typename F> ScaleExpression<Derived, F> operator *(F vol) && {
+
+		static_assert(!ExpressionOperand<Derived>::isAudio,
+				"a temporary Audio cannot be an operand: name it first");
+
+		return ScaleExpression<Derived, F>(self(), vol);
+
+	}
+
+	// SAVE (evaluates the expression into the saved Audio)
+	void saveAudioFile(const string& outputFileName) const {
+
+		Audio<typename Derived::value_type>(self()).saveAudioFile(outputFileName);
+
+	}
+
+};
+
+// SumExpression class
+template<typename L, typename R> class SumExpression: public AudioExpression<
+		SumExpression<L, R>> {
+
+private:
+
+	typename ExpressionOperand<L>::type left;
+
+	typename ExpressionOperand<R>::type right;
+
+public:
+
+	typedef typename L::value_type value_type;
+
+	SumExpression(const L& l, const R& r) :
+			left(l), right(r) {
+
+	}
+
+	value_type operator[](long k) const {
+
+		return addSample(left[k], right[k]);
+
+	}
+
+	long size() const {
+
+		return left.size();
+
+	}
+
+	int getSamplingRate() const {
+
+		return left.getSamplingRate();
+
+	}
+
+};
+
+// ScaleExpression class
+template<typename E, typename F> class ScaleExpression: public AudioExpression<
+		ScaleExpression<E, F>> {
+
+private:
+
+	typename ExpressionOperand<E>::type operand;
+
+	F vol;
+
+public:
+
+	typedef typename E::value_type value_type;
+
+	ScaleExpression(const E& e, F v) :
+			operand(e), vol(v) {
+
+	}
+
+	value_type operator[](long k) const {
+
+		return scaleSample(operand[k], vol);
+
+	}
+
+	long size() const {
+
+		return operand.size();
+
+	}
+
+	int getSamplingRate() const {
+
+		return operand.getSamplingRate();
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+//=================================================================================
+// Name        : FFT.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Built-in power-of-two complex FFT (radix-4 Stockham with a final
+// 				 radix-2 stage) on split real/imaginary float arrays
+//=================================================================================
+
+#include <cmath>
+#include <vector>
+
+#ifndef LIBS_FFT_H
+#define LIBS_FFT_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// FFT class
+/*A plan holds the twiddle table for one transform size and is read-only once
+built, so one plan can be shared by many threads (each with its own work
+arrays). Data is kept in split format (separate real and imaginary arrays) so
+the butterfly loops are plain float loops that the compiler vectorizes.*/
+class FFT {
+
+private:
+
+	int size;
+
+	vector<float> cosTable, sinTable;
+
+	/*Stockham autosort transform: no bit reversal pass and the inner loops run
+	over contiguous data. The result ends up back in (re, im).*/
+	void transform(float* re, float* im, float* workRe, float* workIm) const {
+
+		float* xr = re;
+		float* xi = im;
+		float* yr = workRe;
+		float* yi = workIm;
+
+		bool inWork = false;
+
+		int n = size, s = 1;
+
+		// radix-4 stages
+		while (n >= 4) {
+
+			int n1 = n / 4, step = size / n;
+
+			for (int p = 0; p < n1; ++p) {
+
+				float w1r = cosTable[p * step], w1i = sinTable[p * step];
+				float w2r = cosTable[2 * p * step], w2i = sinTable[2 * p * step];
+				float w3r = cosTable[3 * p * step], w3i = sinTable[3 * p * step];
+
+				const float* ar = xr + s * p;
+				const float* ai = xi + s * p;
+				const float* br = xr + s * (p + n1);
+				const float* bi = xi + s * (p + n1);
+				const float* cr = xr + s * (p + 2 * n1);
+				const float* ci = xi + s * (p + 2 * n1);
+				const float* dr = xr + s * (p + 3 * n1);
+				const float* di = xi + s * (p + 3 * n1);
+
+				float* y0r = yr + s * (4 * p);
+				float* y0i = yi + s * (4 * p);
+				float* y1r = y0r + s;
+				float* y1i = y0i + s;
+				float* y2r = y1r + s;
+				float* y2i = y1i + s;
+				float* y3r = y2r + s;
+				float* y3i = y2i + s;
+
+				// butterflies (vectorized over q)
+				for (int q = 0; q < s; ++q) {
+
+					float apcR = ar[q] + cr[q], apcI = ai[q] + ci[q];
+					float amcR = ar[q] - cr[q], amcI = ai[q] - ci[q];
+					float bpdR = br[q] + dr[q], bpdI = bi[q] + di[q];
+
+					// j * (b - d)
+					float jbmdR = di[q] - bi[q], jbmdI = br[q] - dr[q];
+
+					float t1r = amcR - jbmdR, t1i = amcI - jbmdI;
+					float t2r = apcR - bpdR, t2i = apcI - bpdI;
+					float t3r = amcR + jbmdR, t3i = amcI + jbmdI;
+
+					y0r[q] = apcR + bpdR;
+					y0i[q] = apcI + bpdI;
+
+					y1r[q] = w1r * t1r - w1i * t1i;
+					y1i[q] = w1r * t1i + w1i * t1r;
+
+					y2r[q] = w2r * t2r - w2i * t2i;
+					y2i[q] = w2r * t2i + w2i * t2r;
+
+					y3r[q] = w3r * t3r - w3i * t3i;
+					y3i[q] = w3r * t3i + w3i * t3r;
+
+				}
+
+			}
+
+			swap(xr, yr);
+			swap(xi, yi);
+
+			inWork = !inWork;
+
+			n /= 4;
+
+			s *= 4;
+
+		}
+
+		// final radix-2 stage (odd powers of two), written back to (re, im)
+		if (n == 2) {
+
+			for (int q = 0; q < s; ++q) {
+
+				float aR = xr[q], aI = xi[q], bR = xr[q + s], bI = xi[q + s];
+
+				re[q] = aR + bR;
+				im[q] = aI + bI;
+
+				re[q + s] = aR - bR;
+				im[q + s] = aI - bI;
+
+			}
+
+		} else if (inWork) {
+
+			copy(xr, xr + size, re);
+
+			copy(xi, xi + size, im);
+
+		}
+
+	}
+
+public:
+
+	// CONSTRUCTOR
+	FFT(int n) :
+			size(n), cosTable(n), sinTable(n) {
+
+		for (int k = 0; k < n; ++k) {
+
+			double theta = 2.0 * M_PI * k / n;
+
+			cosTable[k] = (float) cos(theta);
+
+			sinTable[k] = (float) -sin(theta);
+
+		}
+
+	}
+
+	int getSize() const {
+
+		return size;
+
+	}
+
+	// forward transform in place; work arrays must hold getSize() floats each
+	void forward(float* re, float* im, float* workRe, float* workIm) const {
+
+		transform(re, im, workRe, workIm);
+
+	}
+
+	// inverse transform in place, scaled by 1/n
+	void inverse(float* re, float* im, float* workRe, float* workIm) const {
+
+		for (int k = 0; k < size; ++k) {
+
+			im[k] = -im[k];
+
+		}
+
+		transform(re, im, workRe, workIm);
+
+		float scale = 1.0f / size;
+
+		for (int k = 0; k < size; ++k) {
+
+			re[k] = re[k] * scale;
+
+			im[k] = -im[k] * scale;
+
+		}
+
+	}
+
+	// smallest power of two >= n
+	static int nextPowerOfTwo(long n) {
+
+		int p = 1;
+
+		while (p < n) {
+
+			p <<= 1;
+
+		}
+
+		return p;
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,345 @@
+//=================================================================================
+// Name        : Fade.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Gain ramp generation for fades, crossfades and keyframed gain
+// 				 envelopes, one block at a time
+//=================================================================================
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef LIBS_FADE_H
+#define LIBS_FADE_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*Equal-power crossfade gains for positions [first, first + n) of an overlap window
+`window` samples long, with a fade `fade` samples long centred in it: before the
+fade the outgoing clip plays alone, after it the incoming clip does, and inside
+it gainOut = cos(t * pi / 2), gainIn = sin(t * pi / 2) so power stays constant.
+
+The ramp is generated per block: cos/sin are evaluated once at the start of the
+block and then advanced by a fixed rotation per sample, so the mixing loop that
+consumes the gains is free of trigonometry and vectorizes.*/
+inline void crossfadeGains(long first, int n, long window, long fade,
+		float* gainOut, float* gainIn) {
+
+	long offset = (window - fade) / 2;
+
+	double step = fade > 0 ? (M_PI / 2) / fade : 0.0;
+
+	double cosStep = cos(step), sinStep = sin(step);
+
+	bool seeded = false;
+
+	double c = 1.0, s = 0.0;
+
+	for (int k = 0; k < n; ++k) {
+
+		long pos = first + k - offset;
+
+		if (pos < 0) {
+
+			gainOut[k] = 1.0f;
+
+			gainIn[k] = 0.0f;
+
+		} else if (pos >= fade) {
+
+			gainOut[k] = 0.0f;
+
+			gainIn[k] = 1.0f;
+
+		} else {
+
+			if (!seeded) {
+
+				c = cos((pos + 0.5) * step);
+
+				s = sin((pos + 0.5) * step);
+
+				seeded = true;
+
+			} else {
+
+				double cNext = c * cosStep - s * sinStep;
+
+				s = s * cosStep + c * sinStep;
+
+				c = cNext;
+
+			}
+
+			gainOut[k] = (float) c;
+
+			gainIn[k] = (float) s;
+
+		}
+
+	}
+
+}
+
+
+// Keyframe struct: envelope gain factor at a frame position
+struct Keyframe {
+
+	long position;
+
+	float gain;
+
+};
+
+// GainEnvelope class
+/*Volume automation: the gain ramps between keyframes (sorted by position) and
+is held at the first / last keyframe's gain before / after them. A linear
+envelope interpolates the gain factor; an exponential one interpolates in dB (a
+constant gain ratio per sample), which sounds even over long fades. Exponential
+ramps to or from silence start / end at the -60 dB floor instead of 0.
+
+gains(first, n, out) writes the gains for frames [first, first + n) one segment
+at a time: a linear segment is out[k] = base + k * slope and an exponential one
+is seeded once per segment and block and then advanced by its ratio, so the
+loops that apply the envelope never search keyframes or call exp / pow per
+sample. The envelope holds no state, so blocks can be generated in any order
+(and on any thread).*/
+class GainEnvelope {
+
+private:
+
+	vector<Keyframe> keys;
+
+	bool exponential;
+
+public:
+
+	// CONSTRUCTOR
+	GainEnvelope(vector<Keyframe> keyframes, bool exp) :
+			keys(keyframes), exponential(exp) {
+
+		stable_sort(keys.begin(), keys.end(),
+				[](const Keyframe& a, const Keyframe& b) {
+
+					return a.position < b.position;
+
+				});
+
+	}
+
+	/*Fade in over the first fadeIn frames and out over the last fadeOut frames
+	of a clip `length` frames long (fades that overlap meet where the two ramps
+	cross).*/
+	static GainEnvelope fades(long length, long fadeIn, long fadeOut, bool exp) {
+
+		fadeIn = max(0L, min(fadeIn, length));
+
+		fadeOut = max(0L, min(fadeOut, length));
+
+		vector<Keyframe> keys;
+
+		if (fadeIn + fadeOut > length) {
+
+			keys.push_back( { 0, fadeIn > 0 ? 0.0f : 1.0f });
+
+			keys.push_back( { length * fadeIn / (fadeIn + fadeOut), (float) length
+					/ (fadeIn + fadeOut) });
+
+			keys.push_back( { length, fadeOut > 0 ? 0.0f : 1.0f });
+
+		} else {
+
+			keys.push_back( { 0, fadeIn > 0 ? 0.0f : 1.0f });
+
+			keys.push_back( { fadeIn, 1.0f });
+
+			keys.push_back( { length - fadeOut, 1.0f });
+
+			keys.push_back( { length, fadeOut > 0 ? 0.0f : 1.0f });
+
+		}
+
+		return GainEnvelope(keys, exp);
+
+	}
+
+	/*Parse keyframes: comma separated time:gain pairs, the time in seconds and
+	the gain a linear factor (e.g. 0:0,2:1,30:1,32:0.25). Returns false (with
+	the reason in error) for an invalid keyframe.*/
+	static bool tryParse(const string& spec, int rate, bool exp,
+			GainEnvelope& env, string& error) {
+
+		vector<Keyframe> keys;
+
+		stringstream ss(spec);
+
+		string key;
+
+		while (getline(ss, key, ',')) {
+
+			size_t colon = key.find(':');
+
+			double time = atof(key.substr(0, colon).c_str());
+
+			double gain = colon == string::npos ? -1.0 :
+					atof(key.substr(colon + 1).c_str());
+
+			if (time < 0 || gain < 0) {
+
+				error = "invalid keyframe [" + key + "]";
+
+				return false;
+
+			}
+
+			keys.push_back( { (long) llround(time * rate), (float) gain });
+
+		}
+
+		env = GainEnvelope(keys, exp);
+
+		return true;
+
+	}
+
+	// parse keyframes (see tryParse), exiting if one is invalid
+	static GainEnvelope parse(const string& spec, int rate, bool exp) {
+
+		GainEnvelope env(vector<Keyframe>(), exp);
+
+		string error;
+
+		if (!tryParse(spec, rate, exp, env, error)) {
+
+			cout << "Error: " << error << "." << endl;
+
+			exit(1);
+
+		}
+
+		return env;
+
+	}
+
+	void gains(long first, int n, float* out) const {
+
+		if (keys.empty()) {
+
+			fill(out, out + n, 1.0f);
+
+			return;
+
+		}
+
+		// next keyframe after frame `first`
+		int s = (int) (upper_bound(keys.begin(), keys.end(), first,
+				[](long pos, const Keyframe& key) {return pos < key.position;})
+				- keys.begin());
+
+		int k = 0;
+
+		while (k < n) {
+
+			long pos = first + k;
+
+			while (s < keys.size() && keys[s].position <= pos) {
+
+				++s;
+
+			}
+
+			if (s == 0 || s == keys.size()) {
+
+				long until = s == 0 ? keys[0].position : LONG_MAX;
+
+				int m = (int) min((long) (n - k), until - pos);
+
+				fill(out + k, out + k + m, s == 0 ? keys[0].gain : keys.back().gain);
+
+				k += m;
+
+				continue;
+
+			}
+
+			const Keyframe& a = keys[s - 1];
+
+			const Keyframe& b = keys[s];
+
+			int m = (int) min((long) (n - k), b.position - pos);
+
+			double span = b.position - a.position, t = pos - a.position;
+
+			float* g = out + k;
+
+			if (!exponential) {
+
+				double slope = (b.gain - a.gain) / span;
+
+				const float base = (float) (a.gain + t * slope), step = (float) slope;
+
+				for (int j = 0; j < m; ++j) {
+
+					g[j] = base + j * step;
+
+				}
+
+			} else {
+
+				const double floor = 0.001;
+
+				double logA = log(max((double) a.gain, floor));
+
+				double slope = (log(max((double) b.gain, floor)) - logA) / span;
+
+				// 8 interleaved geometric sequences, so the ramp is not one long
+				// chain of dependent multiplies
+				double lane[8], stride = exp(8 * slope);
+
+				for (int i = 0; i < 8; ++i) {
+
+					lane[i] = exp(logA + (t + i) * slope);
+
+				}
+
+				int j = 0;
+
+				for (; j + 8 <= m; j += 8) {
+
+					for (int i = 0; i < 8; ++i) {
+
+						g[j + i] = (float) lane[i];
+
+						lane[i] *= stride;
+
+					}
+
+				}
+
+				for (int i = 0; j < m; ++i, ++j) {
+
+					g[j] = (float) lane[i];
+
+				}
+
+			}
+
+			k += m;
+
+		}
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,483 @@
+//=================================================================================
+// Name        : Fingerprint.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Spectral audio fingerprints (band energy differences) and an
+// 				 on-disk inverted index for finding clips inside stored files
+//=================================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FFT.h"
+#include "Parallel.h"
+
+#ifndef LIBS_FINGERPRINT_H
+#define LIBS_FINGERPRINT_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// fingerprinting works on a ~5.5 kHz copy of the signal
+const int FP_RATE = 5512;
+
+// frame length and hop (in decimated samples), and the band edges in Hz
+const int FP_FRAME = 2048, FP_HOP = 64, FP_BANDS = 33;
+
+const double FP_LOW_HZ = 300.0, FP_HIGH_HZ = 2000.0;
+
+// first word of an index file ("SFPI")
+const uint32_t FP_INDEX_MAGIC = 0x49504653;
+
+/*Fingerprint: one 32-bit word per hop. Bit m of frame n is the sign of
+	(E(n,m) - E(n,m+1)) - (E(n-1,m) - E(n-1,m+1))
+over 33 log-spaced band energies E, so it survives gain changes and small
+amounts of noise. Frames are independent, so they are spread over all cores
+(each thread also computes the frame before its first one).*/
+inline vector<uint32_t> computeFingerprint(const vector<float>& x,
+		int samplingRate, float& hopSeconds) {
+
+	int decimation = max(1, samplingRate / FP_RATE);
+
+	float rate = samplingRate / (float) decimation;
+
+	hopSeconds = FP_HOP * decimation / (float) samplingRate;
+
+	// box-filter decimation
+	long n = x.size() / decimation;
+
+	vector<float> d(n);
+
+	for (long k = 0; k < n; ++k) {
+
+		float total = 0.0f;
+
+		for (int j = 0; j < decimation; ++j) {
+
+			total += x[k * decimation + j];
+
+		}
+
+		d[k] = total;
+
+	}
+
+	long numFrames = n >= FP_FRAME ? (n - FP_FRAME) / FP_HOP + 1 : 0;
+
+	if (numFrames < 2) {
+
+		return vector<uint32_t>();
+
+	}
+
+	// FFT bin range of every band
+	vector<int> edges(FP_BANDS + 1);
+
+	for (int m = 0; m <= FP_BANDS; ++m) {
+
+		double hz = FP_LOW_HZ * pow(FP_HIGH_HZ / FP_LOW_HZ, m / (double) FP_BANDS);
+
+		edges[m] = min(FP_FRAME / 2, (int) (hz * FP_FRAME / rate));
+
+	}
+
+	vector<float> window(FP_FRAME);
+
+	for (int k = 0; k < FP_FRAME; ++k) {
+
+		window[k] = 0.5f - 0.5f * cos(2 * M_PI * k / (FP_FRAME - 1));
+
+	}
+
+	FFT fft(FP_FRAME);
+
+	vector<uint32_t> prints(numFrames - 1);
+
+	parallelFor(numFrames - 1, [&](long begin, long end) {
+
+		vector<float> re(FP_FRAME), im(FP_FRAME), workRe(FP_FRAME), workIm(
+				FP_FRAME), energy(FP_BANDS), previous(FP_BANDS);
+
+		for (long f = begin; f <= end; ++f) {
+
+			const float* frame = d.data() + f * FP_HOP;
+
+			for (int k = 0; k < FP_FRAME; ++k) {
+
+				re[k] = frame[k] * window[k];
+
+				im[k] = 0.0f;
+
+			}
+
+			fft.forward(re.data(), im.data(), workRe.data(), workIm.data());
+
+			for (int m = 0; m < FP_BANDS; ++m) {
+
+				float e = 0.0f;
+
+				for (int b = edges[m]; b < max(edges[m + 1], edges[m] + 1); ++b) {
+
+					e += re[b] * re[b] + im[b] * im[b];
+
+				}
+
+				energy[m] = e;
+
+			}
+
+			if (f > begin) {
+
+				uint32_t word = 0;
+
+				for (int m = 0; m < FP_BANDS - 1; ++m) {
+
+					float diff = (energy[m] - energy[m + 1])
+							- (previous[m] - previous[m + 1]);
+
+					word = (word << 1) | (diff > 0 ? 1 : 0);
+
+				}
+
+				prints[f - 1] = word;
+
+			}
+
+			swap(energy, previous);
+
+		}
+
+	}, 256);
+
+	return prints;
+
+}
+
+// FingerprintIndex class
+/*The index stores every file's fingerprint and a posting list sorted by
+fingerprint word, (word, file, frame), so a lookup is a binary search. A query
+votes for (file, frame offset) pairs over all its exact word hits; the best
+candidates are then verified by the bit error rate over the aligned frames.*/
+class FingerprintIndex {
+
+public:
+
+	struct Entry {
+
+		string name;
+
+		float hopSeconds;
+
+		vector<uint32_t> prints;
+
+	};
+
+	struct Posting {
+
+		uint32_t word, file, frame;
+
+		bool operator <(const Posting& p) const {
+
+			return word < p.word;
+
+		}
+
+	};
+
+	struct Match {
+
+		string name;
+
+		float offsetSeconds, bitErrorRate;
+
+		int votes;
+
+	};
+
+private:
+
+	vector<Entry> files;
+
+	vector<Posting> postings;
+
+	template<typename T> static void writeValue(ofstream& oFile, const T& v) {
+
+		oFile.write(reinterpret_cast<const char *>(&v), sizeof(T));
+
+	}
+
+	template<typename T> static void readValue(ifstream& iFile, T& v) {
+
+		iFile.read((char *) &v, sizeof(T));
+
+	}
+
+	void buildPostings() {
+
+		postings.clear();
+
+		for (uint32_t f = 0; f < files.size(); ++f) {
+
+			for (uint32_t k = 0; k < files[f].prints.size(); ++k) {
+
+				// all-zero words come from silence and match everything silent
+				if (files[f].prints[k] != 0) {
+
+					Posting p = { files[f].prints[k], f, k };
+
+					postings.push_back(p);
+
+				}
+
+			}
+
+		}
+
+		stable_sort(postings.begin(), postings.end());
+
+	}
+
+	// fraction of differing bits between query and file f starting at frame
+	float bitErrorRate(const vector<uint32_t>& query, int f, long frame) const {
+
+		const vector<uint32_t>& prints = files[f].prints;
+
+		long bits = 0, errors = 0;
+
+		for (long q = 0; q < query.size(); ++q) {
+
+			long k = frame + q;
+
+			if (k < 0 || k >= prints.size()) {
+
+				continue;
+
+			}
+
+			errors += __builtin_popcount(query[q] ^ prints[k]);
+
+			bits += 32;
+
+		}
+
+		return bits > 0 ? errors / (float) bits : 1.0f;
+
+	}
+
+public:
+
+	// load an existing index (a missing file gives an empty index)
+	bool load(const string& fileName) {
+
+		ifstream iFile(fileName, ios::binary | ios::in);
+
+		if (!iFile.is_open()) {
+
+			return false;
+
+		}
+
+		uint32_t magic = 0, numFiles = 0, numPostings = 0;
+
+		readValue(iFile, magic);
+
+		if (magic != FP_INDEX_MAGIC) {
+
+			cout << "Error: [" << fileName << "] is not a fingerprint index."
+					<< endl;
+
+			exit(1);
+
+		}
+
+		readValue(iFile, numFiles);
+
+		files.resize(numFiles);
+
+		for (int f = 0; f < numFiles; ++f) {
+
+			uint32_t nameLength = 0, numPrints = 0;
+
+			readValue(iFile, nameLength);
+
+			files[f].name.resize(nameLength);
+
+			iFile.read(&files[f].name[0], nameLength);
+
+			readValue(iFile, files[f].hopSeconds);
+
+			readValue(iFile, numPrints);
+
+			files[f].prints.resize(numPrints);
+
+			iFile.read((char *) files[f].prints.data(),
+					numPrints * sizeof(uint32_t));
+
+		}
+
+		readValue(iFile, numPostings);
+
+		postings.resize(numPostings);
+
+		iFile.read((char *) postings.data(), numPostings * sizeof(Posting));
+
+		return true;
+
+	}
+
+	void save(const string& fileName) {
+
+		ofstream oFile(fileName, ios::binary | ios::out);
+
+		if (!oFile.is_open()) {
+
+			cout << "Error: unable to open index file." << endl;
+
+			exit(1);
+
+		}
+
+		writeValue(oFile, FP_INDEX_MAGIC);
+
+		writeValue(oFile, (uint32_t) files.size());
+
+		for (int f = 0; f < files.size(); ++f) {
+
+			writeValue(oFile, (uint32_t) files[f].name.size());
+
+			oFile.write(files[f].name.data(), files[f].name.size());
+
+			writeValue(oFile, files[f].hopSeconds);
+
+			writeValue(oFile, (uint32_t) files[f].prints.size());
+
+			oFile.write(reinterpret_cast<const char *>(files[f].prints.data()),
+					files[f].prints.size() * sizeof(uint32_t));
+
+		}
+
+		writeValue(oFile, (uint32_t) postings.size());
+
+		oFile.write(reinterpret_cast<const char *>(postings.data()),
+				postings.size() * sizeof(Posting));
+
+	}
+
+	// add (or replace) a file's fingerprint; postings are rebuilt by commit()
+	void add(const string& name, float hopSeconds,
+			const vector<uint32_t>& prints) {
+
+		Entry e = { name, hopSeconds, prints };
+
+		for (int f = 0; f < files.size(); ++f) {
+
+			if (files[f].name == name) {
+
+				files[f] = e;
+
+				return;
+
+			}
+
+		}
+
+		files.push_back(e);
+
+	}
+
+	void commit() {
+
+		buildPostings();
+
+	}
+
+	int size() const {
+
+		return files.size();
+
+	}
+
+	/*Query: the stored files containing the clip, best first, with the offset of
+	the clip inside each. Only candidates whose aligned bit error rate is below
+	maxBitErrorRate are returned.*/
+	vector<Match> query(const vector<uint32_t>& prints,
+			float maxBitErrorRate = 0.35f, int maxCandidates = 10) const {
+
+		unordered_map<uint64_t, int> votes;
+
+		for (uint32_t q = 0; q < prints.size(); ++q) {
+
+			if (prints[q] == 0) {
+
+				continue;
+
+			}
+
+			Posting key = { prints[q], 0, 0 };
+
+			pair<vector<Posting>::const_iterator, vector<Posting>::const_iterator> hits =
+					equal_range(postings.begin(), postings.end(), key);
+
+			for (vector<Posting>::const_iterator p = hits.first; p != hits.second;
+					++p) {
+
+				// offset may be negative (clip starting before the stored file)
+				int64_t offset = (int64_t) p->frame - (int64_t) q;
+
+				votes[((uint64_t) p->file << 32) | (uint32_t) (int32_t) offset]++;
+
+			}
+
+		}
+
+		vector<pair<int, uint64_t>> ranked;
+
+		for (unordered_map<uint64_t, int>::const_iterator v = votes.begin();
+				v != votes.end(); ++v) {
+
+			ranked.push_back(make_pair(v->second, v->first));
+
+		}
+
+		sort(ranked.rbegin(), ranked.rend());
+
+		vector<Match> matches;
+
+		vector<bool> reported(files.size(), false);
+
+		for (int k = 0; k < ranked.size() && k < maxCandidates; ++k) {
+
+			int f = (int) (ranked[k].second >> 32);
+
+			long frame = (int32_t) (uint32_t) ranked[k].second;
+
+			float ber = bitErrorRate(prints, f, frame);
+
+			if (ber <= maxBitErrorRate && !reported[f]) {
+
+				Match m = { files[f].name, frame * files[f].hopSeconds, ber,
+						ranked[k].first };
+
+				matches.push_back(m);
+
+				reported[f] = true;
+
+			}
+
+		}
+
+		return matches;
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+//=================================================================================
+// Name        : Frame.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : N-channel sample frames with a compile-time channel count, the
+// 				 per-channel access shared by every layout and the unrolled
+// 				 per-channel loop used by the generic Audio class
+//=================================================================================
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#ifndef LIBS_FRAME_H
+#define LIBS_FRAME_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*One sample per channel, in file (interleaved) order: Frame<int16_t, 6> is a 5.1
+frame. Audio<Frame<BitCount, N>> is the generic N-channel Audio class; the
+frames of a clip are contiguous, so the samples are also one flat array.*/
+template<typename BitCount, size_t N> using Frame = array<BitCount, N>;
+
+/*forEachChannel<N>(f) calls f(0), f(1), ..., f(N - 1) with the loop written out
+at compile time, so the per-channel work inside a frame is fully unrolled and
+the loop over frames around it is left to the vectorizer.*/
+template<size_t N> struct ChannelLoop {
+
+	template<typename F> static void apply(F& f) {
+
+		ChannelLoop<N - 1>::apply(f);
+
+		f(N - 1);
+
+	}
+
+};
+
+template<> struct ChannelLoop<0> {
+
+	template<typename F> static void apply(F&) {
+
+	}
+
+};
+
+template<size_t N, typename F> inline void forEachChannel(F f) {
+
+	ChannelLoop<N>::apply(f);
+
+}
+
+/*FrameTraits<S>: the sample type and channel count of a frame of any layout (a
+mono sample, a stereo pair or a Frame); Rebind<T> is the same layout holding T
+samples.*/
+template<typename S> struct FrameTraits {
+
+	typedef S sample_type;
+
+	static const size_t channels = 1;
+
+	template<typename T> using Rebind = T;
+
+};
+
+template<typename BitCount> struct FrameTraits<pair<BitCount, BitCount>> {
+
+	typedef BitCount sample_type;
+
+	static const size_t channels = 2;
+
+	template<typename T> using Rebind = pair<T, T>;
+
+};
+
+template<typename BitCount, size_t N> struct FrameTraits<Frame<BitCount, N>> {
+
+	typedef BitCount sample_type;
+
+	static const size_t channels = N;
+
+	template<typename T> using Rebind = Frame<T, N>;
+
+};
+
+/*channelSample(s, c): channel c of a frame of any layout, by reference. Inside
+forEachChannel c is a constant, so the access folds to a plain load or store.
+(Per-channel factors such as volumes use the same layouts, so they are read
+with it as well.)*/
+template<typename S> inline typename enable_if<is_arithmetic<S>::value, S&>::type channelSample(
+		S& s, size_t) {
+
+	return s;
+
+}
+
+template<typename S> inline typename enable_if<is_arithmetic<S>::value,
+		const S&>::type channelSample(const S& s, size_t) {
+
+	return s;
+
+}
+
+template<typename BitCount> inline BitCount& channelSample(
+		pair<BitCount, BitCount>& s, size_t c) {
+
+	return c == 0 ? s.first : s.second;
+
+}
+
+template<typename BitCount> inline const BitCount& channelSample(
+		const pair<BitCount, BitCount>& s, size_t c) {
+
+	return c == 0 ? s.first : s.second;
+
+}
+
+template<typename BitCount, size_t N> inline BitCount& channelSample(
+		Frame<BitCount, N>& s, size_t c) {
+
+	return s[c];
+
+}
+
+template<typename BitCount, size_t N> inline const BitCount& channelSample(
+		const Frame<BitCount, N>& s, size_t c) {
+
+	return s[c];
+
+}
+
+// channel c of a frame as an int, and set from one (as the .slac codec works)
+template<typename S> inline int getChannel(const S& s, int c) {
+
+	return channelSample(s, c);
+
+}
+
+template<typename S> inline void setChannel(S& s, int c, int v) {
+
+	channelSample(s, c) = (typename FrameTraits<S>::sample_type) v;
+
+}
+
+}
+
+#endif
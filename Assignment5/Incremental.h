@@ -0,0 +1,207 @@
+//=================================================================================
+// Name        : Incremental.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Persistent per-file processing state, so a growing recording is
+// 				 processed one appended tail at a time (--state)
+//=================================================================================
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Lossless.h"
+#include "Reduce.h"
+
+#ifndef LIBS_INCREMENTAL_H
+#define LIBS_INCREMENTAL_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// ProcessingState struct
+/*What an earlier run has already done to an input file: the operation it ran
+(with its arguments and the input and output file names, so a state file is
+never applied to the wrong job), how many frames it consumed, the running sum of squares per
+channel (for -rms and -norm) and the filter state (for -filter). Stored as one
+"key values..." line per field.*/
+struct ProcessingState {
+
+	string job;
+
+	long offset;
+
+	int64_t sumSquares[2];
+
+	vector<float> filterState;
+
+	ProcessingState() :
+			offset(0) {
+
+		sumSquares[0] = sumSquares[1] = 0;
+
+	}
+
+	// load a state file (false, and a fresh state, if it does not exist yet)
+	bool load(const string& fileName) {
+
+		ifstream iFile(fileName);
+
+		if (!iFile.is_open()) {
+
+			return false;
+
+		}
+
+		string line;
+
+		while (getline(iFile, line)) {
+
+			stringstream fields(line);
+
+			string key;
+
+			fields >> key;
+
+			if (key == "job") {
+
+				getline(fields >> ws, job);
+
+			} else if (key == "offset") {
+
+				fields >> offset;
+
+			} else if (key == "sumSquares") {
+
+				fields >> sumSquares[0] >> sumSquares[1];
+
+			} else if (key == "filter") {
+
+				float v;
+
+				while (fields >> v) {
+
+					filterState.push_back(v);
+
+				}
+
+			}
+
+		}
+
+		return true;
+
+	}
+
+	/*Save the state: written to a temporary file that is renamed over the old
+	one, so a crash leaves either the old or the new state, never a mix.*/
+	void save(const string& fileName) const {
+
+		string tempFileName = fileName + ".tmp";
+
+		writeTo(tempFileName);
+
+		if (rename(tempFileName.c_str(), fileName.c_str()) != 0) {
+
+			cout << "Error: unable to write state file." << endl;
+
+			exit(1);
+
+		}
+
+	}
+
+	void writeTo(const string& fileName) const {
+
+		ofstream oFile(fileName);
+
+		if (!oFile.is_open()) {
+
+			cout << "Error: unable to write state file." << endl;
+
+			exit(1);
+
+		}
+
+		oFile.precision(17);
+
+		oFile << "job " << job << endl;
+
+		oFile << "offset " << offset << endl;
+
+		oFile << "sumSquares " << sumSquares[0] << " " << sumSquares[1] << endl;
+
+		oFile.precision(9);
+
+		oFile << "filter";
+
+		for (int k = 0; k < filterState.size(); ++k) {
+
+			oFile << " " << filterState[k];
+
+		}
+
+		oFile << endl;
+
+		oFile.close();
+
+		if (oFile.fail()) {
+
+			cout << "Error: unable to write state file." << endl;
+
+			exit(1);
+
+		}
+
+	}
+
+	// add a block of frames to the running sums of squares (exact, see Reduce.h)
+	template<typename Frame> void accumulate(const vector<Frame>& samples,
+			int numChannels) {
+
+		const Frame* frames = samples.data();
+
+		for (int c = 0; c < numChannels; ++c) {
+
+			sumSquares[c] += reduceBlocks<int64_t>((long) samples.size(), 0,
+					[frames, c](long begin, long end) {
+
+						int64_t total = 0;
+
+						for (long k = begin; k < end; ++k) {
+
+							int32_t v = getChannel(frames[k], c);
+
+							total += v * v;
+
+						}
+
+						return total;
+
+					}, plus<int64_t>());
+
+		}
+
+		offset += samples.size();
+
+	}
+
+	// rms of everything processed so far
+	float rms(int channel) const {
+
+		return offset > 0 ? (float) sqrt(sumSquares[channel] / (double) offset) : 0.0f;
+
+	}
+
+};
+
+}
+
+#endif
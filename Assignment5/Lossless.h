@@ -0,0 +1,555 @@
+//=================================================================================
+// Name        : Lossless.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Lossless compressed sample container (.slac): fixed linear
+// 				 prediction plus Rice-coded residuals in independent frames
+//=================================================================================
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "AsyncIO.h"
+#include "Frame.h"
+#include "Parallel.h"
+
+#ifndef LIBS_LOSSLESS_H
+#define LIBS_LOSSLESS_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*File layout:
+	header     (LosslessHeader, 32 bytes)
+	offsets    (numFrames + 1 uint64 byte offsets of the frames, from the end of
+	            the offset table)
+	frames     (numFrames frames of frameSize samples, the last one shorter)
+Every frame codes each channel on its own: a 3-bit predictor order (0-4, the
+fixed polynomial predictors), then the residuals in partitions of
+SLAC_PARTITION samples, each with a 5-bit Rice parameter. Frames never refer to
+each other, so they are encoded and decoded in parallel and a range of samples
+only needs the frames that overlap it.*/
+struct LosslessHeader {
+
+	uint32_t magic, bitCount, numChannels, samplingRate, frameSize, numFrames;
+
+	uint64_t numSamples;
+
+};
+
+// first word of a .slac file ("SLAC")
+const uint32_t SLAC_MAGIC = 0x43414C53;
+
+const int SLAC_FRAME = 4096, SLAC_PARTITION = 256, SLAC_MAX_ORDER = 4;
+
+// SLAC_ESCAPE ones (no terminating zero) are followed by the raw 32-bit value
+const int SLAC_ESCAPE = 24;
+
+// write saved audio as .slac instead of .raw (set by --slac)
+inline bool& losslessOutput() {
+
+	static bool enabled = false;
+
+	return enabled;
+
+}
+
+// BitWriter class
+class BitWriter {
+
+private:
+
+	vector<uint8_t> bytes;
+
+	uint64_t acc;
+
+	int numBits;
+
+public:
+
+	// CONSTRUCTOR
+	BitWriter() :
+			acc(0), numBits(0) {
+
+	}
+
+	// write the low `bits` bits of value (bits <= 32), most significant first
+	void put(uint32_t value, int bits) {
+
+		acc = (acc << bits) | (value & ((1ULL << bits) - 1));
+
+		numBits += bits;
+
+		while (numBits >= 8) {
+
+			numBits -= 8;
+
+			bytes.push_back((uint8_t) (acc >> numBits));
+
+		}
+
+	}
+
+	// q ones followed by a zero (q < 32)
+	void putUnary(int q) {
+
+		put(((1U << q) - 1) << 1, q + 1);
+
+	}
+
+	vector<uint8_t>& finish() {
+
+		if (numBits > 0) {
+
+			put(0, 8 - numBits);
+
+		}
+
+		return bytes;
+
+	}
+
+};
+
+// BitReader class
+class BitReader {
+
+private:
+
+	const uint8_t* p;
+
+	const uint8_t* end;
+
+	uint64_t acc;
+
+	int numBits;
+
+public:
+
+	// CONSTRUCTOR
+	BitReader(const uint8_t* begin, const uint8_t* e) :
+			p(begin), end(e), acc(0), numBits(0) {
+
+	}
+
+	uint32_t get(int bits) {
+
+		while (numBits < bits) {
+
+			acc = (acc << 8) | (p < end ? *p++ : 0);
+
+			numBits += 8;
+
+		}
+
+		numBits -= bits;
+
+		return (uint32_t) ((acc >> numBits) & ((1ULL << bits) - 1));
+
+	}
+
+	int getUnary() {
+
+		int q = 0;
+
+		while (q < SLAC_ESCAPE && get(1) == 1) {
+
+			++q;
+
+		}
+
+		return q;
+
+	}
+
+};
+
+// fixed polynomial prediction of s[k] (orders above k fall back to order k)
+inline int predictSample(const int* s, int k, int order) {
+
+	switch (order < k ? order : k) {
+
+	case 1:
+		return s[k - 1];
+
+	case 2:
+		return 2 * s[k - 1] - s[k - 2];
+
+	case 3:
+		return 3 * s[k - 1] - 3 * s[k - 2] + s[k - 3];
+
+	case 4:
+		return 4 * s[k - 1] - 6 * s[k - 2] + 4 * s[k - 3] - s[k - 4];
+
+	default:
+		return 0;
+
+	}
+
+}
+
+inline uint32_t zigzag(int r) {
+
+	return ((uint32_t) r << 1) ^ (uint32_t) (r >> 31);
+
+}
+
+inline int unzigzag(uint32_t u) {
+
+	return (int) (u >> 1) ^ -(int) (u & 1);
+
+}
+
+// encode one channel of a frame: best fixed predictor, Rice-coded residuals
+inline void encodeChannel(const int* s, int n, BitWriter& w) {
+
+	vector<int> residual(n), best(n);
+
+	long bestCost = -1;
+
+	int bestOrder = 0;
+
+	for (int order = 0; order <= SLAC_MAX_ORDER; ++order) {
+
+		long cost = 0;
+
+		for (int k = 0; k < n; ++k) {
+
+			residual[k] = s[k] - predictSample(s, k, order);
+
+			cost += residual[k] < 0 ? -(long) residual[k] : residual[k];
+
+		}
+
+		if (bestCost < 0 || cost < bestCost) {
+
+			bestCost = cost;
+
+			bestOrder = order;
+
+			best.swap(residual);
+
+		}
+
+	}
+
+	w.put(bestOrder, 3);
+
+	for (int first = 0; first < n; first += SLAC_PARTITION) {
+
+		int last = min(first + SLAC_PARTITION, n);
+
+		uint64_t total = 0;
+
+		for (int k = first; k < last; ++k) {
+
+			total += zigzag(best[k]);
+
+		}
+
+		// Rice parameter: 2^k close to the mean residual
+		int k = 0;
+
+		while (k < 30 && ((uint64_t) (last - first) << (k + 1)) <= total) {
+
+			++k;
+
+		}
+
+		w.put(k, 5);
+
+		for (int j = first; j < last; ++j) {
+
+			uint32_t u = zigzag(best[j]);
+
+			uint32_t q = u >> k;
+
+			if (q < SLAC_ESCAPE) {
+
+				w.putUnary(q);
+
+				if (k > 0) {
+
+					w.put(u, k);
+
+				}
+
+			} else {
+
+				w.put((1U << SLAC_ESCAPE) - 1, SLAC_ESCAPE);
+
+				w.put(u, 32);
+
+			}
+
+		}
+
+	}
+
+}
+
+inline void decodeChannel(BitReader& r, int* s, int n) {
+
+	int order = r.get(3);
+
+	for (int first = 0; first < n; first += SLAC_PARTITION) {
+
+		int last = min(first + SLAC_PARTITION, n);
+
+		int k = r.get(5);
+
+		for (int j = first; j < last; ++j) {
+
+			int q = r.getUnary();
+
+			uint32_t u = q == SLAC_ESCAPE ? r.get(32) :
+					((uint32_t) q << k) | (k > 0 ? r.get(k) : 0);
+
+			s[j] = unzigzag(u) + predictSample(s, j, order);
+
+		}
+
+	}
+
+}
+
+/*Read and check the header of a .slac file: the magic word, a supported format,
+the standard frame size and a frame count that matches the sample count. Raw
+PCM that happens to start with "SLAC" fails these checks.*/
+inline bool readLosslessHeader(ifstream& iFile, LosslessHeader& header) {
+
+	iFile.read((char *) &header, sizeof(header));
+
+	return iFile.good() && header.magic == SLAC_MAGIC
+			&& (header.bitCount == 8 || header.bitCount == 16)
+			&& (header.numChannels == 1 || header.numChannels == 2
+					|| header.numChannels == 4 || header.numChannels == 6
+					|| header.numChannels == 8) && header.samplingRate > 0
+			&& header.frameSize == SLAC_FRAME
+			&& header.numFrames
+					== (header.numSamples + SLAC_FRAME - 1) / SLAC_FRAME;
+
+}
+
+// is this file a .slac container (checked by its header, see readLosslessHeader)
+inline bool isLosslessFile(const string& fileName) {
+
+	ifstream iFile(fileName, ios::binary | ios::in);
+
+	LosslessHeader header;
+
+	return iFile.is_open() && readLosslessHeader(iFile, header);
+
+}
+
+/*Write samples as .slac: frames are encoded in parallel into their own byte
+buffers and then written in order behind the offset table. Returns the number
+of bytes written.*/
+template<typename Frame> long writeLossless(const string& fileName,
+		const vector<Frame>& samples, int bitCount, int numChannels,
+		int samplingRate) {
+
+	long numFrames = (samples.size() + SLAC_FRAME - 1) / SLAC_FRAME;
+
+	vector<vector<uint8_t>> frames(numFrames);
+
+	parallelFor(numFrames, [&](long begin, long end) {
+
+		vector<int> channel(SLAC_FRAME);
+
+		for (long f = begin; f < end; ++f) {
+
+			long first = f * SLAC_FRAME;
+
+			int n = (int) min((long) SLAC_FRAME, (long) samples.size() - first);
+
+			BitWriter w;
+
+			for (int c = 0; c < numChannels; ++c) {
+
+				for (int k = 0; k < n; ++k) {
+
+					channel[k] = getChannel(samples[first + k], c);
+
+				}
+
+				encodeChannel(channel.data(), n, w);
+
+			}
+
+			frames[f].swap(w.finish());
+
+		}
+
+	});
+
+	LosslessHeader header = { SLAC_MAGIC, (uint32_t) bitCount,
+			(uint32_t) numChannels, (uint32_t) samplingRate, SLAC_FRAME,
+			(uint32_t) numFrames, (uint64_t) samples.size() };
+
+	vector<uint64_t> offsets(numFrames + 1, 0);
+
+	for (long f = 0; f < numFrames; ++f) {
+
+		offsets[f + 1] = offsets[f] + frames[f].size();
+
+	}
+
+	ofstream oFile(fileName, ios::binary | ios::out);
+
+	if (!oFile.is_open()) {
+
+		cout << "Error: unable to open [.slac] file." << endl;
+
+		exit(1);
+
+	}
+
+	noteWrittenFile(fileName);
+
+	oFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	oFile.write(reinterpret_cast<const char *>(offsets.data()),
+			offsets.size() * sizeof(uint64_t));
+
+	for (long f = 0; f < numFrames; ++f) {
+
+		oFile.write(reinterpret_cast<const char *>(frames[f].data()),
+				frames[f].size());
+
+	}
+
+	return sizeof(header) + offsets.size() * sizeof(uint64_t) + offsets.back();
+
+}
+
+/*Read samples [first, last) of a .slac file (last < 0 means to the end). Only
+the frames overlapping the range are read from disk and decoded, in parallel.*/
+template<typename Frame> vector<Frame> readLossless(const string& fileName,
+		int bitCount, int numChannels, long first, long last) {
+
+	ifstream iFile(fileName, ios::binary | ios::in);
+
+	LosslessHeader header;
+
+	if (!iFile.is_open() || !readLosslessHeader(iFile, header)) {
+
+		cout << "Error: unable to open [.slac] file." << endl;
+
+		exit(1);
+
+	}
+
+	if (header.bitCount != bitCount || header.numChannels != numChannels) {
+
+		cout << "Error: [.slac] file is " << header.bitCount << "-bit with "
+				<< header.numChannels << " channel(s)." << endl;
+
+		exit(1);
+
+	}
+
+	long numSamples = (long) header.numSamples;
+
+	last = last < 0 ? numSamples : min(last, numSamples);
+
+	first = max(0L, min(first, last));
+
+	if (first == last) {
+
+		return vector<Frame>();
+
+	}
+
+	long frameSize = header.frameSize;
+
+	long firstFrame = first / frameSize, lastFrame = (last - 1) / frameSize + 1;
+
+	vector<uint64_t> offsets(header.numFrames + 1);
+
+	iFile.read((char *) offsets.data(), offsets.size() * sizeof(uint64_t));
+
+	streamoff dataStart = sizeof(header) + offsets.size() * sizeof(uint64_t);
+
+	iFile.seekg(0, ios::end);
+
+	streamoff fileSize = iFile.tellg();
+
+	// the frames follow each other and the last one ends at the end of the file
+	bool valid = iFile.good() && offsets[0] == 0
+			&& offsets.back() == (uint64_t) (fileSize - dataStart);
+
+	for (long f = 0; valid && f < header.numFrames; ++f) {
+
+		valid = offsets[f] <= offsets[f + 1];
+
+	}
+
+	if (!valid) {
+
+		cout << "Error: corrupt or truncated [.slac] file." << endl;
+
+		exit(1);
+
+	}
+
+	vector<uint8_t> bytes(offsets[lastFrame] - offsets[firstFrame]);
+
+	iFile.seekg(dataStart + (streamoff) offsets[firstFrame]);
+
+	iFile.read((char *) bytes.data(), bytes.size());
+
+	if (!iFile.good()) {
+
+		cout << "Error: unable to read [.slac] file." << endl;
+
+		exit(1);
+
+	}
+
+	vector<Frame> samples((lastFrame - firstFrame) * frameSize);
+
+	parallelFor(lastFrame - firstFrame, [&](long begin, long end) {
+
+		vector<int> channel(frameSize);
+
+		for (long f = firstFrame + begin; f < firstFrame + end; ++f) {
+
+			int n = (int) min(frameSize, numSamples - f * frameSize);
+
+			const uint8_t* p = bytes.data() + (offsets[f] - offsets[firstFrame]);
+
+			BitReader r(p, bytes.data() + (offsets[f + 1] - offsets[firstFrame]));
+
+			Frame* out = samples.data() + (f - firstFrame) * frameSize;
+
+			for (int c = 0; c < numChannels; ++c) {
+
+				decodeChannel(r, channel.data(), n);
+
+				for (int k = 0; k < n; ++k) {
+
+					setChannel(out[k], c, channel[k]);
+
+				}
+
+			}
+
+		}
+
+	});
+
+	long skip = first - firstFrame * frameSize;
+
+	return vector<Frame>(samples.begin() + skip,
+			samples.begin() + skip + (last - first));
+
+}
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+//=================================================================================
+// Name        : Parallel.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Minimal fork/join helper used to spread block processing over all
+// 				 hardware threads
+//=================================================================================
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#ifndef LIBS_PARALLEL_H
+#define LIBS_PARALLEL_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// number of worker threads to use (at least one)
+inline int numWorkerThreads() {
+
+	int n = (int) thread::hardware_concurrency();
+
+	return n > 0 ? n : 1;
+
+}
+
+/*Parallel for: splits [0, n) into one contiguous chunk per thread (each at least
+minChunk long) and calls fn(begin, end) for each chunk. Runs inline when only
+one chunk is needed.*/
+template<typename Function> void parallelFor(long n, Function fn,
+		long minChunk = 1) {
+
+	if (n <= 0) {
+
+		return;
+
+	}
+
+	long numChunks = min((long) numWorkerThreads(),
+			(n + minChunk - 1) / max(minChunk, 1L));
+
+	if (numChunks <= 1) {
+
+		fn(0L, n);
+
+		return;
+
+	}
+
+	vector<thread> threads;
+
+	long chunk = (n + numChunks - 1) / numChunks;
+
+	for (long begin = chunk; begin < n; begin += chunk) {
+
+		threads.push_back(thread(fn, begin, min(begin + chunk, n)));
+
+	}
+
+	fn(0L, min(chunk, n));
+
+	for (int k = 0; k < threads.size(); ++k) {
+
+		threads[k].join();
+
+	}
+
+}
+
+}
+
+#endif
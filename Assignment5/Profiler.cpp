@@ -0,0 +1,66 @@
+//=================================================================================
+// Name        : Profiler.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Heap allocation counter used by the --stats instrumentation
+//=================================================================================
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "Profiler.h"
+
+static atomic<long> numAllocations(0);
+
+long DPLKYL002::allocationCount() {
+
+	return numAllocations.load(memory_order_relaxed);
+
+}
+
+// global operator new/delete replacements so every heap allocation is counted
+void* operator new(size_t size) {
+
+	numAllocations.fetch_add(1, memory_order_relaxed);
+
+	void* p = malloc(size == 0 ? 1 : size);
+
+	if (p == nullptr) {
+
+		throw bad_alloc();
+
+	}
+
+	return p;
+
+}
+
+void* operator new[](size_t size) {
+
+	return operator new(size);
+
+}
+
+void operator delete(void* p) noexcept {
+
+	free(p);
+
+}
+
+void operator delete[](void* p) noexcept {
+
+	free(p);
+
+}
+
+void operator delete(void* p, size_t) noexcept {
+
+	free(p);
+
+}
+
+void operator delete[](void* p, size_t) noexcept {
+
+	free(p);
+
+}
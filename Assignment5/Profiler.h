@@ -0,0 +1,245 @@
+//=================================================================================
+// Name        : Profiler.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Per-stage timing, throughput and memory instrumentation for the
+// 				 audio manipulation program (enabled with --stats)
+//=================================================================================
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sys/resource.h>
+
+#ifndef LIBS_PROFILER_H
+#define LIBS_PROFILER_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// number of heap allocations made so far (counted in Profiler.cpp)
+long allocationCount();
+
+// Profiler class
+/*Collects one record per instrumented stage (load, operator, save) and reports
+them as JSON and, optionally, as a Chrome trace-event file.*/
+class Profiler {
+
+public:
+
+	struct Stage {
+
+		string name;
+
+		double startUs, durationUs;
+
+		long bytes, samples, allocations, peakRSSKb;
+
+	};
+
+private:
+
+	bool enabled;
+
+	string traceFileName;
+
+	chrono::steady_clock::time_point origin;
+
+	vector<Stage> stages;
+
+	// stages may finish on several threads (inputs loaded concurrently)
+	mutex stagesLock;
+
+	Profiler() :
+			enabled(false), origin(chrono::steady_clock::now()) {
+	}
+
+public:
+
+	static Profiler& instance() {
+
+		static Profiler profiler;
+
+		return profiler;
+
+	}
+
+	void enable(const string& traceFile) {
+
+		enabled = true;
+
+		traceFileName = traceFile;
+
+		origin = chrono::steady_clock::now();
+
+	}
+
+	bool isEnabled() const {
+
+		return enabled;
+
+	}
+
+	// microseconds since the profiler was enabled
+	double now() const {
+
+		return chrono::duration<double, micro>(
+				chrono::steady_clock::now() - origin).count();
+
+	}
+
+	static long peakRSS() {
+
+		struct rusage usage;
+
+		getrusage(RUSAGE_SELF, &usage);
+
+		return usage.ru_maxrss;
+
+	}
+
+	void record(const Stage& stage) {
+
+		lock_guard<mutex> guard(stagesLock);
+
+		stages.push_back(stage);
+
+	}
+
+	// JSON
+	void report(ostream& out) {
+
+		sort(stages.begin(), stages.end(), [](const Stage& a, const Stage& b) {
+			return a.startUs < b.startUs;
+		});
+
+		out << "{\n  \"stages\": [";
+
+		for (int k = 0; k < stages.size(); ++k) {
+
+			const Stage& s = stages[k];
+
+			double seconds = s.durationUs / 1e6;
+
+			out << (k == 0 ? "\n" : ",\n") << "    {\"name\": \"" << s.name
+					<< "\", \"wallMs\": " << s.durationUs / 1e3 << ", \"bytes\": "
+					<< s.bytes << ", \"samples\": " << s.samples
+					<< ", \"samplesPerSec\": "
+					<< (seconds > 0 ? s.samples / seconds : 0)
+					<< ", \"allocations\": " << s.allocations
+					<< ", \"peakRSSKb\": " << s.peakRSSKb << "}";
+
+		}
+
+		out << "\n  ],\n  \"totalWallMs\": " << now() / 1e3
+				<< ",\n  \"peakRSSKb\": " << peakRSS() << "\n}" << endl;
+
+		if (!traceFileName.empty()) {
+
+			writeTrace(traceFileName);
+
+		}
+
+	}
+
+	// Chrome trace-event format (load in chrome://tracing or Perfetto)
+	void writeTrace(const string& fileName) {
+
+		ofstream oFile(fileName);
+
+		if (!oFile.is_open()) {
+
+			cout << "Error: unable to open trace file." << endl;
+
+			return;
+
+		}
+
+		oFile << "{\"traceEvents\": [";
+
+		for (int k = 0; k < stages.size(); ++k) {
+
+			const Stage& s = stages[k];
+
+			oFile << (k == 0 ? "\n" : ",\n") << "  {\"name\": \"" << s.name
+					<< "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": "
+					<< s.startUs << ", \"dur\": " << s.durationUs
+					<< ", \"args\": {\"bytes\": " << s.bytes << ", \"samples\": "
+					<< s.samples << ", \"allocations\": " << s.allocations
+					<< ", \"peakRSSKb\": " << s.peakRSSKb << "}}";
+
+		}
+
+		oFile << "\n]}" << endl;
+
+	}
+
+};
+
+// ScopedStage class
+/*Times the enclosing scope and records it with the profiler on destruction.
+Does nothing unless --stats was given.*/
+class ScopedStage {
+
+private:
+
+	const char* name;
+
+	bool active;
+
+	double startUs;
+
+	long bytes, samples, startAllocations;
+
+public:
+
+	// CONSTRUCTOR
+	ScopedStage(const char* n, long b = 0, long s = 0) :
+			name(n), active(Profiler::instance().isEnabled()), startUs(0), bytes(
+					b), samples(s), startAllocations(0) {
+
+		if (active) {
+
+			startAllocations = allocationCount();
+
+			startUs = Profiler::instance().now();
+
+		}
+
+	}
+
+	// DESTRUCTOR
+	~ScopedStage() {
+
+		if (active) {
+
+			Profiler& profiler = Profiler::instance();
+
+			Profiler::Stage stage = { name, startUs, profiler.now() - startUs,
+					bytes, samples, allocationCount() - startAllocations,
+					Profiler::peakRSS() };
+
+			profiler.record(stage);
+
+		}
+
+	}
+
+	void setWork(long b, long s) {
+
+		bytes = b;
+
+		samples = s;
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+//=================================================================================
+// Name        : Reduce.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Deterministic parallel reductions: fixed-size blocks combined
+// 				 pairwise in block order, whatever the number of threads
+//=================================================================================
+
+#include <vector>
+#include "Parallel.h"
+
+#ifndef LIBS_REDUCE_H
+#define LIBS_REDUCE_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// frames per reduction block (fixed, so the partials never depend on the threads)
+const long REDUCE_BLOCK = 1 << 15;
+
+/*Reduce [0, n): blockFn(begin, end) reduces one REDUCE_BLOCK-sized block, the
+blocks are spread over all cores, and the partials are combined pairwise in
+block order (a balanced tree) with combine(a, b). The blocks and the order of
+every combination are fixed by n alone, so floating-point results are
+bit-identical for any number of threads, and their rounding error grows with
+log(n / REDUCE_BLOCK) rather than with n. Integer partials are exact anyway.*/
+template<typename T, typename BlockFunction, typename Combine> T reduceBlocks(
+		long n, const T& zero, BlockFunction blockFn, Combine combine) {
+
+	long numBlocks = (n + REDUCE_BLOCK - 1) / REDUCE_BLOCK;
+
+	if (numBlocks <= 0) {
+
+		return zero;
+
+	}
+
+	vector<T> partials(numBlocks, zero);
+
+	parallelFor(numBlocks, [&](long begin, long end) {
+
+		for (long b = begin; b < end; ++b) {
+
+			partials[b] = blockFn(b * REDUCE_BLOCK, min(n, (b + 1) * REDUCE_BLOCK));
+
+		}
+
+	});
+
+	// pairwise: neighbours first, then pairs of pairs ...
+	for (long width = 1; width < numBlocks; width *= 2) {
+
+		for (long b = 0; b + width < numBlocks; b += 2 * width) {
+
+			partials[b] = combine(partials[b], partials[b + width]);
+
+		}
+
+	}
+
+	return partials[0];
+
+}
+
+}
+
+#endif
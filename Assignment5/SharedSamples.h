@@ -0,0 +1,261 @@
+//=================================================================================
+// Name        : SharedSamples.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Reference-counted, copy-on-write sample storage for Audio
+//=================================================================================
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifndef LIBS_SHAREDSAMPLES_H
+#define LIBS_SHAREDSAMPLES_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// IngestStats struct
+/*Per-channel statistics of a sample buffer, gathered while it was loaded: the
+exact sum of squares, the peak magnitude and the number of frames.*/
+struct IngestStats {
+
+	long frames;
+
+	vector<int64_t> sumSquares;
+
+	vector<int> peak;
+
+	IngestStats(int numChannels) :
+			frames(0), sumSquares(numChannels, 0), peak(numChannels, 0) {
+
+	}
+
+	float rms(int channel) const {
+
+		return frames > 0 ?
+				(float) sqrt(sumSquares[channel] / (double) frames) : 0.0f;
+
+	}
+
+};
+
+// SharedSamples class
+/*A std::vector-like handle on a reference-counted sample buffer. Copying a
+handle shares the buffer; the const members only read it, and the first
+non-const access (element writes, iterators, data(), resize, erase ...) through
+a handle whose buffer is shared gives that handle its own copy. clear() and
+assigning a new vector never copy: they just point the handle at new storage.
+So copies of an Audio cost nothing until one of them is changed, and memory
+scales with the number of distinct buffers rather than handles.
+IngestStats attached to a buffer travel with it and are dropped by the first
+write access, so they always describe the samples the handle holds.*/
+template<typename T> class SharedSamples {
+
+private:
+
+	shared_ptr<vector<T>> buffer;
+
+	shared_ptr<const IngestStats> stats;
+
+	// unique buffer for writing (duplicated here if other handles share it)
+	vector<T>& mutate() {
+
+		stats.reset();
+
+		if (buffer.use_count() > 1) {
+
+			buffer = make_shared<vector<T>>(*buffer);
+
+		}
+
+		return *buffer;
+
+	}
+
+public:
+
+	typedef T value_type;
+
+	typedef typename vector<T>::iterator iterator;
+
+	typedef typename vector<T>::const_iterator const_iterator;
+
+	// CONSTRUCTORS
+	SharedSamples() :
+			buffer(make_shared<vector<T>>()) {
+
+	}
+
+	SharedSamples(const vector<T>& v) :
+			buffer(make_shared<vector<T>>(v)) {
+
+	}
+
+	SharedSamples(vector<T>&& v) :
+			buffer(make_shared<vector<T>>(move(v))) {
+
+	}
+
+	SharedSamples& operator =(const vector<T>& v) {
+
+		buffer = make_shared<vector<T>>(v);
+
+		stats.reset();
+
+		return *this;
+
+	}
+
+	SharedSamples& operator =(vector<T>&& v) {
+
+		buffer = make_shared<vector<T>>(move(v));
+
+		stats.reset();
+
+		return *this;
+
+	}
+
+	// READ-ONLY ACCESS (never copies)
+	const vector<T>& read() const {
+
+		return *buffer;
+
+	}
+
+	size_t size() const {
+
+		return buffer->size();
+
+	}
+
+	bool empty() const {
+
+		return buffer->empty();
+
+	}
+
+	const T& operator[](size_t k) const {
+
+		return (*buffer)[k];
+
+	}
+
+	const_iterator begin() const {
+
+		return buffer->begin();
+
+	}
+
+	const_iterator end() const {
+
+		return buffer->end();
+
+	}
+
+	const T* data() const {
+
+		return buffer->data();
+
+	}
+
+	// is the buffer shared with another handle
+	bool shared() const {
+
+		return buffer.use_count() > 1;
+
+	}
+
+	// statistics gathered while loading, or nullptr once the samples were written to
+	const IngestStats* getStats() const {
+
+		return stats.get();
+
+	}
+
+	void setStats(const shared_ptr<const IngestStats>& s) {
+
+		stats = s;
+
+	}
+
+	// WRITE ACCESS (copies a shared buffer first)
+	vector<T>& write() {
+
+		return mutate();
+
+	}
+
+	T& operator[](size_t k) {
+
+		return mutate()[k];
+
+	}
+
+	iterator begin() {
+
+		return mutate().begin();
+
+	}
+
+	iterator end() {
+
+		return mutate().end();
+
+	}
+
+	T* data() {
+
+		return mutate().data();
+
+	}
+
+	void resize(size_t n) {
+
+		mutate().resize(n);
+
+	}
+
+	template<typename It> void insert(iterator position, It first, It last) {
+
+		mutate().insert(position, first, last);
+
+	}
+
+	void erase(iterator first, iterator last) {
+
+		mutate().erase(first, last);
+
+	}
+
+	void swap(vector<T>& v) {
+
+		mutate().swap(v);
+
+	}
+
+	void clear() {
+
+		stats.reset();
+
+		if (buffer.use_count() > 1) {
+
+			buffer = make_shared<vector<T>>();
+
+		} else {
+
+			buffer->clear();
+
+		}
+
+	}
+
+};
+
+}
+
+#endif
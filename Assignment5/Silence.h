@@ -0,0 +1,104 @@
+//=================================================================================
+// Name        : Silence.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Silence detection: runs of samples whose magnitude stays below a
+// 				 threshold, found with a block-wise abs-max scan
+//=================================================================================
+
+#include <algorithm>
+#include <vector>
+#include "Parallel.h"
+
+#ifndef LIBS_SILENCE_H
+#define LIBS_SILENCE_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// samples per block in the abs-max scan
+const int SILENCE_BLOCK = 256;
+
+/*Find silent runs [first, last) of at least minSamples frames among n frames,
+where magnitude(k) is the largest absolute sample of frame k (over all its
+channels, so every channel has to be quiet).
+
+First pass: the maximum magnitude of every block, a branch-free loop that
+vectorizes and runs on all cores. Second pass: walk the blocks; quiet blocks
+extend the current run, and only blocks containing a loud sample are looked at
+sample by sample to find the exact run boundaries.*/
+template<typename Magnitude> vector<pair<long, long>> findSilentRuns(long n,
+		Magnitude magnitude, int threshold, long minSamples) {
+
+	minSamples = max(minSamples, 1L);
+
+	long numBlocks = (n + SILENCE_BLOCK - 1) / SILENCE_BLOCK;
+
+	vector<int> blockMax(numBlocks);
+
+	parallelFor(numBlocks, [&](long begin, long end) {
+
+		for (long b = begin; b < end; ++b) {
+
+			long first = b * SILENCE_BLOCK, last = min(first + SILENCE_BLOCK, n);
+
+			int m = 0;
+
+			for (long k = first; k < last; ++k) {
+
+				m = max(m, magnitude(k));
+
+			}
+
+			blockMax[b] = m;
+
+		}
+
+	}, 1024);
+
+	vector<pair<long, long>> runs;
+
+	long runStart = 0;
+
+	for (long b = 0; b < numBlocks; ++b) {
+
+		if (blockMax[b] < threshold) {
+
+			continue;
+
+		}
+
+		long first = b * SILENCE_BLOCK, last = min(first + SILENCE_BLOCK, n);
+
+		for (long k = first; k < last; ++k) {
+
+			if (magnitude(k) >= threshold) {
+
+				if (k - runStart >= minSamples) {
+
+					runs.push_back(make_pair(runStart, k));
+
+				}
+
+				runStart = k + 1;
+
+			}
+
+		}
+
+	}
+
+	if (n - runStart >= minSamples) {
+
+		runs.push_back(make_pair(runStart, n));
+
+	}
+
+	return runs;
+
+}
+
+}
+
+#endif
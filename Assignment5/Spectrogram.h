@@ -0,0 +1,333 @@
+//=================================================================================
+// Name        : Spectrogram.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Windowed STFT spectrogram (two real frames per complex FFT, frames
+// 				 spread over all cores) written as PGM / PPM images or a float matrix
+//=================================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "FFT.h"
+#include "Parallel.h"
+
+#ifndef LIBS_SPECTROGRAM_H
+#define LIBS_SPECTROGRAM_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// first word of a binary magnitude matrix ("SSPG")
+const uint32_t SPECTROGRAM_MAGIC = 0x47505353;
+
+// dynamic range mapped onto the image grey / colour scale
+const float SPECTROGRAM_RANGE_DB = 80.0f;
+
+/*10 log10(x) for a positive normal float: the exponent gives whole octaves and
+the mantissa, folded into [0.707, 1.414), goes through the atanh series
+ln m = 2 (s + s^3/3 + s^5/5 + s^7/7), s = (m - 1) / (m + 1). The error is
+below 1e-5 dB, and unlike log10f the loop it sits in can be vectorized.*/
+inline float powerToDb(float x) {
+
+	uint32_t bits;
+
+	memcpy(&bits, &x, sizeof(bits));
+
+	int e = (int) (bits >> 23) - 127;
+
+	bits = (bits & 0x007FFFFF) | 0x3F800000;
+
+	float m;
+
+	memcpy(&m, &bits, sizeof(m));
+
+	bool fold = m > 1.41421356f;
+
+	m = fold ? 0.5f * m : m;
+
+	e += fold ? 1 : 0;
+
+	float s = (m - 1.0f) / (m + 1.0f), s2 = s * s;
+
+	float ln = 2.0f * s
+			* (1.0f + s2 * (1.0f / 3 + s2 * (1.0f / 5 + s2 * (1.0f / 7))));
+
+	return 3.01029996f * e + 4.34294482f * ln;
+
+}
+
+// analysis window (hann, hamming, blackman or rect)
+inline vector<float> windowFunction(const string& name, int n) {
+
+	vector<float> w(n, 1.0f);
+
+	for (int k = 0; k < n; ++k) {
+
+		double t = 2 * M_PI * k / (n - 1);
+
+		if (name == "hann") {
+
+			w[k] = (float) (0.5 - 0.5 * cos(t));
+
+		} else if (name == "hamming") {
+
+			w[k] = (float) (0.54 - 0.46 * cos(t));
+
+		} else if (name == "blackman") {
+
+			w[k] = (float) (0.42 - 0.5 * cos(t) + 0.08 * cos(2 * t));
+
+		} else if (name != "rect") {
+
+			cout << "Error: unknown window [" << name << "]." << endl;
+
+			exit(1);
+
+		}
+
+	}
+
+	return w;
+
+}
+
+/*Fractional FFT bin shown by each of `rows` output rows (row 0 = lowest): linear
+rows are the bins themselves, log rows are log-spaced from the first bin to
+Nyquist and mel rows are evenly spaced on the mel scale from 0 Hz.*/
+inline vector<float> rowBins(const string& scale, int rows, int size,
+		int samplingRate) {
+
+	vector<float> bins(rows);
+
+	double nyquist = size / 2.0, binHz = samplingRate / (double) size;
+
+	for (int r = 0; r < rows; ++r) {
+
+		double t = rows > 1 ? r / (double) (rows - 1) : 0.0;
+
+		if (scale == "linear") {
+
+			bins[r] = (float) r;
+
+		} else if (scale == "log") {
+
+			bins[r] = (float) pow(nyquist, t);
+
+		} else if (scale == "mel") {
+
+			double melMax = 2595.0 * log10(1.0 + nyquist * binHz / 700.0);
+
+			bins[r] = (float) (700.0 * (pow(10.0, t * melMax / 2595.0) - 1.0)
+					/ binHz);
+
+		} else {
+
+			cout << "Error: unknown frequency scale [" << scale << "]." << endl;
+
+			exit(1);
+
+		}
+
+	}
+
+	return bins;
+
+}
+
+// Spectrogram class
+/*Power in dB (10 log10 |X|^2) of `cols` STFT frames by `rows` frequency rows,
+stored frame by frame (rows between bins interpolate the bins' dB values). Two
+real frames go through each complex FFT (one in the real part, one in the
+imaginary part) and are separated afterwards with
+X[k] = (Z[k] + conj Z[N-k]) / 2 and Y[k] = (Z[k] - conj Z[N-k]) / 2i, which
+halves the number of transforms.*/
+class Spectrogram {
+
+private:
+
+	int rows, cols;
+
+	vector<float> db;
+
+	// heat colour map: black, red, yellow, white
+	static void heat(float t, unsigned char* rgb) {
+
+		for (int c = 0; c < 3; ++c) {
+
+			float v = 3.0f * t - c;
+
+			rgb[c] = (unsigned char) (255.0f * min(1.0f, max(0.0f, v)));
+
+		}
+
+	}
+
+public:
+
+	// CONSTRUCTOR
+	Spectrogram(const vector<float>& x, int samplingRate, int size, int hop,
+			const string& window, const string& scale) :
+			rows(size / 2), cols(
+					x.size() >= size ? (int) ((x.size() - size) / hop + 1) : 0) {
+
+		vector<float> w = windowFunction(window, size);
+
+		vector<float> bins = rowBins(scale, rows, size, samplingRate);
+
+		db.resize((long) rows * cols);
+
+		FFT fft(size);
+
+		int half = size / 2;
+
+		parallelFor((cols + 1) / 2, [&](long begin, long end) {
+
+			vector<float> re(size), im(size), workRe(size), workIm(size),
+					dbA(half + 1), dbB(half + 1);
+
+			for (long p = begin; p < end; ++p) {
+
+				long a = 2 * p, b = min(2 * p + 1, (long) cols - 1);
+
+				const float* frameA = x.data() + a * hop;
+
+				const float* frameB = x.data() + b * hop;
+
+				for (int k = 0; k < size; ++k) {
+
+					re[k] = frameA[k] * w[k];
+
+					im[k] = frameB[k] * w[k];
+
+				}
+
+				fft.forward(re.data(), im.data(), workRe.data(), workIm.data());
+
+				for (int k = 0; k <= half; ++k) {
+
+					int j = (size - k) & (size - 1);
+
+					float sr = re[k] + re[j], si = im[k] - im[j];
+
+					float dr = re[k] - re[j], di = im[k] + im[j];
+
+					dbA[k] = powerToDb(0.25f * (sr * sr + si * si) + 1e-12f);
+
+					dbB[k] = powerToDb(0.25f * (dr * dr + di * di) + 1e-12f);
+
+				}
+
+				for (int r = 0; r < rows; ++r) {
+
+					int k = min((int) bins[r], half - 1);
+
+					float f = min(1.0f, bins[r] - k);
+
+					db[a * rows + r] = dbA[k] + f * (dbA[k + 1] - dbA[k]);
+
+					db[b * rows + r] = dbB[k] + f * (dbB[k + 1] - dbB[k]);
+
+				}
+
+			}
+
+		}, 16);
+
+	}
+
+	int numRows() const {
+
+		return rows;
+
+	}
+
+	int numCols() const {
+
+		return cols;
+
+	}
+
+	/*Image: one column per frame, highest frequency at the top; the top
+	SPECTROGRAM_RANGE_DB dB are mapped onto grey levels (PGM) or a heat colour
+	map (PPM).*/
+	void writeImage(const string& fileName, bool colour) const {
+
+		ofstream oFile(fileName, ios::binary | ios::out);
+
+		if (!oFile.is_open()) {
+
+			cout << "Error: unable to open image file." << endl;
+
+			exit(1);
+
+		}
+
+		float top = db.empty() ? 0.0f : *max_element(db.begin(), db.end());
+
+		oFile << (colour ? "P6" : "P5") << "\n" << cols << " " << rows
+				<< "\n255\n";
+
+		vector<unsigned char> line((long) cols * (colour ? 3 : 1));
+
+		for (int r = rows - 1; r >= 0; --r) {
+
+			for (long c = 0; c < cols; ++c) {
+
+				float t = 1.0f + (db[c * rows + r] - top) / SPECTROGRAM_RANGE_DB;
+
+				t = min(1.0f, max(0.0f, t));
+
+				if (colour) {
+
+					heat(t, &line[c * 3]);
+
+				} else {
+
+					line[c] = (unsigned char) (255.0f * t);
+
+				}
+
+			}
+
+			oFile.write((const char *) line.data(), line.size());
+
+		}
+
+	}
+
+	/*Binary matrix: magic, rows and cols (uint32), then cols frames of rows float
+	dB values (lowest frequency first).*/
+	void writeMatrix(const string& fileName) const {
+
+		ofstream oFile(fileName, ios::binary | ios::out);
+
+		if (!oFile.is_open()) {
+
+			cout << "Error: unable to open matrix file." << endl;
+
+			exit(1);
+
+		}
+
+		uint32_t header[3] = { SPECTROGRAM_MAGIC, (uint32_t) rows,
+				(uint32_t) cols };
+
+		oFile.write((const char *) header, sizeof(header));
+
+		oFile.write((const char *) db.data(), db.size() * sizeof(float));
+
+	}
+
+};
+
+}
+
+#endif
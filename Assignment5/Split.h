@@ -0,0 +1,213 @@
+//=================================================================================
+// Name        : Split.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : One-pass multi-segment split: copy byte ranges of a .raw file into
+// 				 many output files concurrently, without decoding samples
+//=================================================================================
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "AsyncIO.h"
+#include "Parallel.h"
+#include "Profiler.h"
+
+#ifndef LIBS_SPLIT_H
+#define LIBS_SPLIT_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+/*Parse a split specification into [first, last) frame ranges: either a segment
+length in seconds ("30" cuts the whole file into 30 s pieces) or a comma
+separated list of time ranges in seconds ("0-12.5,40-61"). Ranges are clipped
+to the file.*/
+inline vector<pair<long, long>> parseSegments(const string& spec,
+		int samplingRate, long numFrames) {
+
+	vector<pair<long, long>> segments;
+
+	if (spec.find('-') == string::npos && spec.find(',') == string::npos) {
+
+		long length = (long) (atof(spec.c_str()) * samplingRate);
+
+		if (length <= 0) {
+
+			cout << "Error: invalid segment length [" << spec << "]." << endl;
+
+			exit(1);
+
+		}
+
+		for (long first = 0; first < numFrames; first += length) {
+
+			segments.push_back(make_pair(first, min(first + length, numFrames)));
+
+		}
+
+		return segments;
+
+	}
+
+	stringstream ss(spec);
+
+	string range;
+
+	while (getline(ss, range, ',')) {
+
+		size_t dash = range.find('-');
+
+		if (dash == string::npos) {
+
+			cout << "Error: invalid range [" << range << "]." << endl;
+
+			exit(1);
+
+		}
+
+		long first = (long) (atof(range.substr(0, dash).c_str()) * samplingRate);
+
+		long last = (long) (atof(range.substr(dash + 1).c_str()) * samplingRate);
+
+		first = max(0L, min(first, numFrames));
+
+		last = max(first, min(last, numFrames));
+
+		segments.push_back(make_pair(first, last));
+
+	}
+
+	return segments;
+
+}
+
+/*Copy `length` bytes at `offset` of inFd into outFd. copy_file_range keeps the
+data in the kernel (and can share extents on filesystems that support it);
+pread/write is the fallback when the kernel or filesystem refuses.*/
+inline bool copyByteRange(int inFd, int outFd, off_t offset, size_t length) {
+
+	off_t inOffset = offset, outOffset = 0;
+
+	while (length > 0) {
+
+		ssize_t n = copy_file_range(inFd, &inOffset, outFd, &outOffset, length,
+				0);
+
+		if (n <= 0) {
+
+			break;
+
+		}
+
+		length -= n;
+
+	}
+
+	vector<char> buffer(length > 0 ? 1 << 20 : 0);
+
+	while (length > 0) {
+
+		ssize_t n = pread(inFd, buffer.data(), min(length, buffer.size()),
+				inOffset);
+
+		if (n <= 0 || pwrite(outFd, buffer.data(), n, outOffset) != n) {
+
+			return false;
+
+		}
+
+		inOffset += n;
+
+		outOffset += n;
+
+		length -= n;
+
+	}
+
+	return true;
+
+}
+
+/*Split: write frames [first, last) of every segment to its own file. Segments
+are written concurrently; the input is never decoded, so the cost is one read
+of the covered bytes however many segments there are.*/
+inline void splitFile(const string& inputFileName,
+		const vector<pair<long, long>>& segments, int frameBytes,
+		const vector<string>& outputFileNames) {
+
+	int inFd = open(inputFileName.c_str(), O_RDONLY);
+
+	if (inFd < 0) {
+
+		cout << "Error: unable to open [.raw] file." << endl;
+
+		exit(1);
+
+	}
+
+	long totalBytes = 0;
+
+	for (int k = 0; k < segments.size(); ++k) {
+
+		totalBytes += (segments[k].second - segments[k].first) * frameBytes;
+
+	}
+
+	ScopedStage stage("split", totalBytes, totalBytes / frameBytes);
+
+	atomic<bool> ok(true);
+
+	parallelFor((long) segments.size(), [&](long begin, long end) {
+
+		for (long k = begin; k < end; ++k) {
+
+			int outFd = open(outputFileNames[k].c_str(),
+					O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+			if (outFd < 0 || !copyByteRange(inFd, outFd,
+					(off_t) segments[k].first * frameBytes,
+					(size_t) (segments[k].second - segments[k].first) * frameBytes)) {
+
+				ok = false;
+
+			}
+
+			if (outFd >= 0) {
+
+				close(outFd);
+
+			}
+
+		}
+
+	});
+
+	close(inFd);
+
+	for (int k = 0; k < outputFileNames.size(); ++k) {
+
+		noteWrittenFile(outputFileNames[k]);
+
+	}
+
+	if (!ok) {
+
+		cout << "Error: unable to write [.raw] file." << endl;
+
+		exit(1);
+
+	}
+
+}
+
+}
+
+#endif
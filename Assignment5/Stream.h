@@ -0,0 +1,233 @@
+//=================================================================================
+// Name        : Stream.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Streaming mode: read raw samples from stdin in fixed-size blocks,
+// 				 apply per-block operations and write the result to stdout
+//=================================================================================
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Audio.h"
+#include "AsyncIO.h"
+
+#ifndef LIBS_STREAM_H
+#define LIBS_STREAM_H
+
+using namespace std;
+
+namespace DPLKYL002 {
+
+// StreamOp struct
+/*One per-block operation: "-v" (volume, gain per channel), "-add" (mix with the
+matching block of a file) or "-filter" (biquad cascade spec).*/
+struct StreamOp {
+
+	string name;
+
+	pair<float, float> vol;
+
+	string arg;
+
+};
+
+// volume for a mono block
+template<typename BitCount> Audio<BitCount> scaleBlock(Audio<BitCount>& audio,
+		pair<float, float> vol) {
+
+	return audio * vol.first;
+
+}
+
+// volume for a stereo block
+template<typename BitCount> Audio<pair<BitCount, BitCount>> scaleBlock(
+		Audio<pair<BitCount, BitCount>>& audio, pair<float, float> vol) {
+
+	return audio * vol;
+
+}
+
+// AudioStream class
+/*Processes an unbounded stream block by block, so memory use is fixed and each
+block leaves as soon as it has been processed. Latency is the time to fill a
+block (blockFrames / samplingRate) plus the time to process it; both are
+reported on stderr at the end of the stream (stdout carries the audio). Reads
+and writes are double-buffered: block k + 1 is read and block k - 1 written
+(AsyncFile, one request at a time so the pipes stay in order) while block k is
+processed.*/
+template<typename Frame> class AudioStream {
+
+private:
+
+	int samplingRate, numChannels, blockFrames;
+
+	vector<StreamOp> ops;
+
+	vector<BiquadChain> chains;
+
+	vector<unique_ptr<ifstream>> mixFiles;
+
+public:
+
+	// CONSTRUCTOR
+	AudioStream(int sRate, int nChannels, int bFrames,
+			const vector<StreamOp>& o) :
+			samplingRate(sRate), numChannels(nChannels), blockFrames(bFrames), ops(
+					o) {
+
+		for (int k = 0; k < ops.size(); ++k) {
+
+			if (ops[k].name == "-filter") {
+
+				chains.push_back(
+						BiquadChain::parse(ops[k].arg, samplingRate, numChannels));
+
+			} else if (ops[k].name == "-add") {
+
+				unique_ptr<ifstream> iFile(
+						new ifstream(ops[k].arg, ios::binary | ios::in));
+
+				if (!iFile->is_open()) {
+
+					cerr << "Error: unable to open [.raw] file." << endl;
+
+					exit(1);
+
+				}
+
+				mixFiles.push_back(move(iFile));
+
+			}
+
+		}
+
+	}
+
+	// read the next block of a file to mix in (zero-padded past its end)
+	vector<Frame> readMixBlock(ifstream& iFile, int n) {
+
+		vector<Frame> b(n, Frame());
+
+		iFile.read((char *) b.data(), n * sizeof(Frame));
+
+		return b;
+
+	}
+
+	void run(FILE* in, FILE* out) {
+
+		fflush(out);
+
+		AsyncFile input(fileno(in), 1), output(fileno(out), 1);
+
+		vector<Frame> blocks[2] = { vector<Frame>(blockFrames), vector<Frame>(
+				blockFrames) }, written;
+
+		long numBlocks = 0, numFrames = 0;
+
+		double totalMs = 0, maxMs = 0;
+
+		input.read((char *) blocks[0].data(), blockFrames * sizeof(Frame), -1);
+
+		input.finish();
+
+		size_t n = input.transferred() / sizeof(Frame), read = n * sizeof(Frame);
+
+		for (int current = 0; n > 0; current = 1 - current) {
+
+			// read ahead
+			if (!input.atEnd()) {
+
+				input.read((char *) blocks[1 - current].data(),
+						blockFrames * sizeof(Frame), -1);
+
+			}
+
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+			vector<Frame> samples(blocks[current].begin(),
+					blocks[current].begin() + n);
+
+			int nFrames = (int) n, length = 0;
+
+			Audio<Frame> audio(nFrames, length, samples, numChannels,
+					samplingRate);
+
+			int chain = 0, mix = 0;
+
+			for (int k = 0; k < ops.size(); ++k) {
+
+				if (ops[k].name == "-v") {
+
+					audio = scaleBlock(audio, ops[k].vol);
+
+				} else if (ops[k].name == "-add") {
+
+					Audio<Frame> other(nFrames, length,
+							readMixBlock(*mixFiles[mix++], nFrames), numChannels,
+							samplingRate);
+
+					audio = audio + other;
+
+				} else {
+
+					audio.filter(chains[chain++]);
+
+				}
+
+			}
+
+			double ms = chrono::duration<double, milli>(
+					chrono::steady_clock::now() - start).count();
+
+			totalMs += ms;
+
+			maxMs = max(maxMs, ms);
+
+			++numBlocks;
+
+			numFrames += n;
+
+			// write behind (the previous block has to be out first)
+			output.finish();
+
+			written.assign(audio.getSamples().begin(),
+					audio.getSamples().begin() + n);
+
+			output.write((const char *) written.data(), n * sizeof(Frame), -1);
+
+			input.finish();
+
+			n = (input.transferred() - read) / sizeof(Frame);
+
+			read += n * sizeof(Frame);
+
+		}
+
+		output.finish();
+
+		double bufferMs = 1000.0 * blockFrames / samplingRate;
+
+		cerr << "Stream: " << numBlocks << " blocks, " << numFrames
+				<< " frames, block " << blockFrames << " frames (" << bufferMs
+				<< " ms)" << endl;
+
+		cerr << "Processing per block: avg "
+				<< (numBlocks > 0 ? totalMs / numBlocks : 0) << " ms, max "
+				<< maxMs << " ms" << endl;
+
+		cerr << "End-to-end latency: " << bufferMs + maxMs << " ms (worst case)"
+				<< endl;
+
+	}
+
+};
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+//=================================================================================
+// Name        : Test.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : Checks of properties the samp output alone does not show (make
+// 				 test): prints each check and exits non-zero if one fails
+//=================================================================================
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Audio.h"
+
+using namespace std;
+using namespace DPLKYL002;
+
+int numFailed = 0;
+
+void check(bool passed, const string& name) {
+
+	cout << (passed ? "PASS " : "FAIL ") << name << endl;
+
+	numFailed += passed ? 0 : 1;
+
+}
+
+// a clip of n frames of reproducible pseudo-random samples
+template<typename Frame> Audio<Frame> randomClip(int n, int numChannels,
+		unsigned seed) {
+
+	vector<Frame> v(n);
+
+	srand(seed);
+
+	char* bytes = (char *) v.data();
+
+	for (size_t k = 0; k < v.size() * sizeof(Frame); ++k) {
+
+		bytes[k] = (char) rand();
+
+	}
+
+	return Audio<Frame>(n, n / 44100, move(v), numChannels, 44100);
+
+}
+
+/*(A + B) * F builds expression nodes without allocating, and evaluating it
+allocates only the result: its buffer handle and its samples (two allocations),
+where evaluating A + B and then * F allocates an intermediate Audio as well.*/
+template<typename Frame, typename F> void testExpression(const string& layout,
+		int numChannels, F vol) {
+
+	Audio<Frame> a = randomClip<Frame>(100000, numChannels, 1), b = randomClip<
+			Frame>(100000, numChannels, 2);
+
+	long before = allocationCount();
+
+	auto e = (a + b) * vol;
+
+	long nodeAllocations = allocationCount() - before;
+
+	before = allocationCount();
+
+	Audio<Frame> fused = e;
+
+	long fusedAllocations = allocationCount() - before;
+
+	before = allocationCount();
+
+	Audio<Frame> sum = a + b;
+
+	Audio<Frame> stepwise = sum * vol;
+
+	long stepwiseAllocations = allocationCount() - before;
+
+	bool equal = fused.getSamples().size() == a.getSamples().size();
+
+	for (long k = 0; equal && k < a.getSamples().size(); ++k) {
+
+		equal = fused.getSamples()[k]
+				== scaleSample(addSample(a.getSamples()[k], b.getSamples()[k]), vol)
+				&& fused.getSamples()[k] == stepwise.getSamples()[k];
+
+	}
+
+	check(nodeAllocations == 0, layout + ": (a + b) * f builds no buffers");
+
+	check(fusedAllocations == 2,
+			layout + ": evaluating (a + b) * f allocates only the result ("
+					+ to_string(fusedAllocations) + " allocations)");
+
+	check(stepwiseAllocations == 2 * fusedAllocations,
+			layout + ": a + b then * f allocates an intermediate as well ("
+					+ to_string(stepwiseAllocations) + " allocations)");
+
+	check(equal, layout + ": fused result matches the per-sample operators");
+
+}
+
+// usage: samp_test
+int main() {
+
+	testExpression<int16_t>("mono", 1, 0.5f);
+
+	testExpression<pair<int8_t, int8_t>>("stereo", 2, make_pair(0.5f, 0.25f));
+
+	array<float, 4> vol = { { 0.5f, 0.25f, 1.5f, 1.0f } };
+
+	testExpression<Frame<int16_t, 4>>("quad", 4, vol);
+
+	cout << (numFailed == 0 ? "All checks passed." : "Some checks failed.")
+			<< endl;
+
+	return numFailed == 0 ? 0 : 1;
+
+}
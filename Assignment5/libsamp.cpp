@@ -0,0 +1,839 @@
+//=================================================================================
+// Name        : libsamp.cpp
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : libsamp: the samp.h C API over the Audio classes, on caller
+// 				 buffers, with errors returned as status codes
+//=================================================================================
+
+#include <climits>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+#include "samp.h"
+#include "Audio.h"
+#include "Analysis.h"
+
+using namespace std;
+
+using namespace DPLKYL002;
+
+/*The library has no allocation counter: Profiler.cpp counts allocations by
+replacing the global operator new, which a library must not do to its host.
+--stats is a samp program option only, so the profiler is never enabled here.*/
+long DPLKYL002::allocationCount() {
+
+	return 0;
+
+}
+
+namespace {
+
+thread_local string lastError;
+
+samp_status fail(samp_status status, const string& message) {
+
+	lastError = message;
+
+	return status;
+
+}
+
+/*The per-channel values of a request (gains, target rms) as the std::array
+every Audio layout takes them in.*/
+template<typename Frame> array<float, FrameTraits<Frame>::channels> channelValues(
+		const float* v) {
+
+	array<float, FrameTraits<Frame>::channels> x;
+
+	copy(v, v + x.size(), x.begin());
+
+	return x;
+
+}
+
+// an Audio holding a copy of `frames` frames of a caller buffer
+template<typename Frame> Audio<Frame> wrap(const samp_format* format,
+		const void* samples, size_t frames) {
+
+	const Frame* first = (const Frame*) samples;
+
+	int rate = format->sampling_rate;
+
+	return Audio<Frame>((int) frames, (int) (frames / ((float) rate)),
+			vector<Frame>(first, first + frames), format->channels, rate);
+
+}
+
+// copy a result into the caller's buffer (if it fits)
+template<typename Frame> samp_status unwrap(const Audio<Frame>& audio,
+		void* out, size_t capacity, size_t* outFrames) {
+
+	const vector<Frame>& samples = audio.getSamples();
+
+	if (outFrames != nullptr) {
+
+		*outFrames = samples.size();
+
+	}
+
+	if (samples.size() > capacity) {
+
+		return fail(SAMP_ERROR_BUFFER_TOO_SMALL,
+				"the output needs " + to_string(samples.size()) + " frames");
+
+	}
+
+	if (!samples.empty()) {
+
+		memcpy(out, samples.data(), samples.size() * sizeof(Frame));
+
+	}
+
+	return SAMP_OK;
+
+}
+
+// the arguments of one call (each operation uses the ones it needs)
+struct Request {
+
+	const samp_format* format;
+
+	const void *a, *b;
+
+	size_t aFrames, bFrames, first, last;
+
+	void* out;
+
+	size_t capacity;
+
+	size_t* outFrames;
+
+	const float* values;
+
+	float* results;
+
+	float seconds, fadeIn, fadeOut;
+
+	bool linked, exponential;
+
+	BiquadChain* chain;
+
+	Compressor* compressor;
+
+	const GainEnvelope* env;
+
+	samp_channel_stats* stats;
+
+};
+
+// a request on one clip (a) whose result (if any) has the same length
+Request request(const samp_format* format, const void* in, size_t frames,
+		void* out) {
+
+	Request r = Request();
+
+	r.format = format;
+
+	r.a = in;
+
+	r.aFrames = frames;
+
+	r.out = out;
+
+	r.capacity = frames;
+
+	return r;
+
+}
+
+// a request on two clips (a, b) writing up to `capacity` frames
+Request request(const samp_format* format, const void* a, size_t aFrames,
+		const void* b, size_t bFrames, void* out, size_t capacity,
+		size_t* outFrames) {
+
+	Request r = request(format, a, aFrames, out);
+
+	r.b = b;
+
+	r.bFrames = bFrames;
+
+	r.capacity = capacity;
+
+	r.outFrames = outFrames;
+
+	return r;
+
+}
+
+bool validBuffer(const void* samples, size_t frames) {
+
+	return frames <= INT_MAX && (samples != nullptr || frames == 0);
+
+}
+
+bool validOutput(const Request& r) {
+
+	return r.out != nullptr || r.capacity == 0;
+
+}
+
+/*Run Job::run<Frame>(r) for the sample layout of the format, turning exceptions
+into status codes so none escapes into C code.*/
+template<typename Job> samp_status dispatch(const Request& r) {
+
+	const samp_format* format = r.format;
+
+	lastError.clear();
+
+	if (format == nullptr || format->sampling_rate <= 0
+			|| (format->bit_count != 8 && format->bit_count != 16)) {
+
+		return fail(SAMP_ERROR_FORMAT, "unsupported sampling rate or bit count");
+
+	}
+
+	bool wide = format->bit_count == 16;
+
+	try {
+
+		switch (format->channels) {
+
+		case 1:
+
+			return wide ?
+					Job::template run<int16_t>(r) : Job::template run<int8_t>(r);
+
+		case 2:
+
+			return wide ?
+					Job::template run<pair<int16_t, int16_t>>(r) :
+					Job::template run<pair<int8_t, int8_t>>(r);
+
+		case 4:
+
+			return wide ?
+					Job::template run<Frame<int16_t, 4>>(r) :
+					Job::template run<Frame<int8_t, 4>>(r);
+
+		case 6:
+
+			return wide ?
+					Job::template run<Frame<int16_t, 6>>(r) :
+					Job::template run<Frame<int8_t, 6>>(r);
+
+		case 8:
+
+			return wide ?
+					Job::template run<Frame<int16_t, 8>>(r) :
+					Job::template run<Frame<int8_t, 8>>(r);
+
+		default:
+
+			return fail(SAMP_ERROR_FORMAT, "unsupported channel count");
+
+		}
+
+	} catch (const bad_alloc&) {
+
+		return fail(SAMP_ERROR_OUT_OF_MEMORY, "out of memory");
+
+	} catch (const exception& e) {
+
+		return fail(SAMP_ERROR_INTERNAL, e.what());
+
+	} catch (...) {
+
+		return fail(SAMP_ERROR_INTERNAL, "unknown error");
+
+	}
+
+}
+
+// JOBS (one per operation, run for each sample layout)
+
+struct AddJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		Audio<Frame> a = wrap<Frame>(r.format, r.a, r.aFrames), b = wrap<Frame>(
+				r.format, r.b, r.bFrames);
+
+		Audio<Frame> sum = a + b;
+
+		return unwrap(sum, r.out, r.capacity, r.outFrames);
+
+	}
+
+};
+
+struct RangedAddJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		return unwrap(
+				wrap<Frame>(r.format, r.a, r.aFrames).rangedAdd(
+						wrap<Frame>(r.format, r.b, r.bFrames),
+						make_pair((int) r.first, (int) r.last)), r.out, r.capacity,
+				r.outFrames);
+
+	}
+
+};
+
+struct CutJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		const Frame* samples = (const Frame*) r.a;
+
+		return unwrap(
+				wrap<Frame>(r.format, samples, r.first)
+						| wrap<Frame>(r.format, samples + r.last + 1,
+								r.aFrames - r.last - 1), r.out, r.capacity,
+				r.outFrames);
+
+	}
+
+};
+
+struct ConcatJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		return unwrap(
+				wrap<Frame>(r.format, r.a, r.aFrames)
+						| wrap<Frame>(r.format, r.b, r.bFrames), r.out, r.capacity,
+				r.outFrames);
+
+	}
+
+};
+
+struct CrossfadeJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		int overlap = (int) (r.seconds * r.format->sampling_rate);
+
+		return unwrap(
+				wrap<Frame>(r.format, r.a, r.aFrames).crossfade(
+						wrap<Frame>(r.format, r.b, r.bFrames), overlap), r.out, r.capacity,
+				r.outFrames);
+
+	}
+
+};
+
+struct ReverseJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		Audio<Frame> audio = wrap<Frame>(r.format, r.a, r.aFrames);
+
+		audio.revOrdering();
+
+		return unwrap(audio, r.out, r.capacity, r.outFrames);
+
+	}
+
+};
+
+struct VolumeJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		Audio<Frame> in = wrap<Frame>(r.format, r.a, r.aFrames);
+
+		Audio<Frame> audio = in * channelValues<Frame>(r.values);
+
+		return unwrap(audio, r.out, r.capacity, r.outFrames);
+
+	}
+
+};
+
+struct NormalizeJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		Audio<Frame> audio = wrap<Frame>(r.format, r.a, r.aFrames);
+
+		audio.normalizeSound(channelValues<Frame>(r.values));
+
+		return unwrap(audio, r.out, r.capacity, r.outFrames);
+
+	}
+
+};
+
+struct FilterJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		Audio<Frame> audio = wrap<Frame>(r.format, r.a, r.aFrames);
+
+		audio.filter(*r.chain);
+
+		return unwrap(audio, r.out, r.capacity, r.outFrames);
+
+	}
+
+};
+
+struct CompressJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		Audio<Frame> audio = wrap<Frame>(r.format, r.a, r.aFrames);
+
+		audio.compress(*r.compressor, r.linked);
+
+		return unwrap(audio, r.out, r.capacity, r.outFrames);
+
+	}
+
+};
+
+// envelope, or fades when there is none
+struct EnvelopeJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		Audio<Frame> audio = wrap<Frame>(r.format, r.a, r.aFrames);
+
+		int rate = r.format->sampling_rate;
+
+		audio.envelope(
+				r.env != nullptr ?
+						*r.env :
+						GainEnvelope::fades((long) r.aFrames, lround(r.fadeIn * rate),
+								lround(r.fadeOut * rate), r.exponential));
+
+		return unwrap(audio, r.out, r.capacity, r.outFrames);
+
+	}
+
+};
+
+struct RmsJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		array<float, FrameTraits<Frame>::channels> rms = wrap<Frame>(r.format,
+				r.a, r.aFrames).channelRMS();
+
+		copy(rms.begin(), rms.end(), r.results);
+
+		return SAMP_OK;
+
+	}
+
+};
+
+struct StatsJob {
+
+	template<typename Frame> static samp_status run(const Request& r) {
+
+		Audio<Frame> audio = wrap<Frame>(r.format, r.a, r.aFrames);
+
+		int bits = r.format->bit_count;
+
+		vector<ChannelStats> channels = analyze(audio.getSamples(),
+				r.format->channels, bits, 1);
+
+		double n = max(r.aFrames, (size_t) 1);
+
+		for (int c = 0; c < channels.size(); ++c) {
+
+			const ChannelStats& s = channels[c];
+
+			samp_channel_stats& stats = r.stats[c];
+
+			stats.min = r.aFrames > 0 ? s.minimum : 0;
+
+			stats.max = r.aFrames > 0 ? s.maximum : 0;
+
+			stats.peak = max(abs(stats.min), abs(stats.max));
+
+			stats.peak_dbfs = toDbfs(stats.peak, bits);
+
+			stats.rms = sqrt(s.sumSquares / n);
+
+			stats.rms_dbfs = toDbfs(stats.rms, bits);
+
+			stats.dc_offset = s.sum / n;
+
+			stats.clipped_samples = s.clips;
+
+			stats.zero_crossings = s.zeroCrossings;
+
+		}
+
+		return SAMP_OK;
+
+	}
+
+};
+
+samp_status invalid(const char* message) {
+
+	return fail(SAMP_ERROR_ARGUMENT, message);
+
+}
+
+}
+
+// C API
+
+const char* samp_last_error(void) {
+
+	return lastError.c_str();
+
+}
+
+samp_status samp_add(const samp_format* format, const void* a, size_t a_frames,
+		const void* b, size_t b_frames, void* out, size_t capacity,
+		size_t* out_frames) {
+
+	Request r = request(format, a, a_frames, b, b_frames, out, capacity,
+			out_frames);
+
+	if (!validBuffer(a, a_frames) || !validBuffer(b, b_frames)
+			|| !validOutput(r)) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	return dispatch<AddJob>(r);
+
+}
+
+samp_status samp_ranged_add(const samp_format* format, const void* a,
+		size_t a_frames, const void* b, size_t b_frames, size_t first,
+		size_t last, void* out) {
+
+	Request r = request(format, a, a_frames, b, b_frames, out, a_frames,
+			nullptr);
+
+	r.first = first;
+
+	r.last = last;
+
+	if (!validBuffer(a, a_frames) || !validBuffer(b, b_frames)
+			|| !validOutput(r)) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	if (first > last || last > min(a_frames, b_frames)) {
+
+		return invalid("invalid range");
+
+	}
+
+	return dispatch<RangedAddJob>(r);
+
+}
+
+samp_status samp_cut(const samp_format* format, const void* in, size_t frames,
+		size_t first, size_t last, void* out, size_t capacity,
+		size_t* out_frames) {
+
+	Request r = request(format, in, frames, nullptr, 0, out, capacity,
+			out_frames);
+
+	r.first = first;
+
+	r.last = last;
+
+	if (!validBuffer(in, frames) || !validOutput(r)) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	if (first > last || last >= frames) {
+
+		return invalid("invalid range");
+
+	}
+
+	return dispatch<CutJob>(r);
+
+}
+
+samp_status samp_concat(const samp_format* format, const void* a,
+		size_t a_frames, const void* b, size_t b_frames, void* out,
+		size_t capacity, size_t* out_frames) {
+
+	Request r = request(format, a, a_frames, b, b_frames, out, capacity,
+			out_frames);
+
+	if (!validBuffer(a, a_frames) || !validBuffer(b, b_frames)
+			|| !validOutput(r) || a_frames + b_frames > INT_MAX) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	return dispatch<ConcatJob>(r);
+
+}
+
+samp_status samp_crossfade(const samp_format* format, const void* a,
+		size_t a_frames, const void* b, size_t b_frames, float seconds,
+		void* out, size_t capacity, size_t* out_frames) {
+
+	Request r = request(format, a, a_frames, b, b_frames, out, capacity,
+			out_frames);
+
+	r.seconds = seconds;
+
+	if (!validBuffer(a, a_frames) || !validBuffer(b, b_frames)
+			|| !validOutput(r) || a_frames + b_frames > INT_MAX) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	if (!(seconds >= 0)) {
+
+		return invalid("invalid crossfade length");
+
+	}
+
+	return dispatch<CrossfadeJob>(r);
+
+}
+
+samp_status samp_reverse(const samp_format* format, const void* in,
+		size_t frames, void* out) {
+
+	Request r = request(format, in, frames, out);
+
+	if (!validBuffer(in, frames) || !validOutput(r)) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	return dispatch<ReverseJob>(r);
+
+}
+
+samp_status samp_volume(const samp_format* format, const void* in,
+		size_t frames, const float* gains, void* out) {
+
+	Request r = request(format, in, frames, out);
+
+	r.values = gains;
+
+	if (!validBuffer(in, frames) || !validOutput(r) || gains == nullptr) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	return dispatch<VolumeJob>(r);
+
+}
+
+samp_status samp_rms(const samp_format* format, const void* in, size_t frames,
+		float* rms) {
+
+	Request r = request(format, in, frames, nullptr);
+
+	r.results = rms;
+
+	if (!validBuffer(in, frames) || rms == nullptr) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	return dispatch<RmsJob>(r);
+
+}
+
+samp_status samp_normalize(const samp_format* format, const void* in,
+		size_t frames, const float* rms, void* out) {
+
+	Request r = request(format, in, frames, out);
+
+	r.values = rms;
+
+	if (!validBuffer(in, frames) || !validOutput(r) || rms == nullptr) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	return dispatch<NormalizeJob>(r);
+
+}
+
+samp_status samp_filter(const samp_format* format, const void* in,
+		size_t frames, const char* spec, void* out) {
+
+	Request r = request(format, in, frames, out);
+
+	if (!validBuffer(in, frames) || !validOutput(r) || format == nullptr
+			|| spec == nullptr) {
+
+		return invalid("invalid buffer, format or filter specification");
+
+	}
+
+	BiquadChain chain(vector<Biquad>(), format->channels);
+
+	string error;
+
+	if (!BiquadChain::tryParse(spec, format->sampling_rate, format->channels,
+			chain, error)) {
+
+		return fail(SAMP_ERROR_SPEC, error);
+
+	}
+
+	r.chain = &chain;
+
+	return dispatch<FilterJob>(r);
+
+}
+
+samp_status samp_compress(const samp_format* format, const void* in,
+		size_t frames, float threshold_db, float ratio, float attack_ms,
+		float release_ms, float lookahead_ms, int linked, void* out) {
+
+	Request r = request(format, in, frames, out);
+
+	if (!validBuffer(in, frames) || !validOutput(r) || format == nullptr) {
+
+		return invalid("invalid buffer or format");
+
+	}
+
+	if (!(ratio >= 1) || !(attack_ms >= 0) || !(release_ms >= 0)
+			|| !(lookahead_ms >= 0)) {
+
+		return invalid("invalid compressor settings");
+
+	}
+
+	Compressor compressor(threshold_db, ratio, attack_ms, release_ms,
+			lookahead_ms, format->sampling_rate);
+
+	r.compressor = &compressor;
+
+	r.linked = linked != 0;
+
+	return dispatch<CompressJob>(r);
+
+}
+
+samp_status samp_limit(const samp_format* format, const void* in,
+		size_t frames, float threshold_db, float release_ms, float lookahead_ms,
+		int linked, void* out) {
+
+	Request r = request(format, in, frames, out);
+
+	if (!validBuffer(in, frames) || !validOutput(r) || format == nullptr) {
+
+		return invalid("invalid buffer or format");
+
+	}
+
+	if (!(release_ms >= 0) || !(lookahead_ms >= 0)) {
+
+		return invalid("invalid limiter settings");
+
+	}
+
+	Compressor limiter = Compressor::limiter(threshold_db, release_ms,
+			lookahead_ms, format->sampling_rate);
+
+	r.compressor = &limiter;
+
+	r.linked = linked != 0;
+
+	return dispatch<CompressJob>(r);
+
+}
+
+samp_status samp_fade(const samp_format* format, const void* in, size_t frames,
+		float fade_in, float fade_out, int exponential, void* out) {
+
+	Request r = request(format, in, frames, out);
+
+	r.fadeIn = fade_in;
+
+	r.fadeOut = fade_out;
+
+	r.exponential = exponential != 0;
+
+	if (!validBuffer(in, frames) || !validOutput(r)) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	if (!(fade_in >= 0) || !(fade_out >= 0)) {
+
+		return invalid("invalid fade length");
+
+	}
+
+	return dispatch<EnvelopeJob>(r);
+
+}
+
+samp_status samp_envelope(const samp_format* format, const void* in,
+		size_t frames, const char* keyframes, int exponential, void* out) {
+
+	Request r = request(format, in, frames, out);
+
+	if (!validBuffer(in, frames) || !validOutput(r) || format == nullptr
+			|| keyframes == nullptr) {
+
+		return invalid("invalid buffer, format or keyframes");
+
+	}
+
+	GainEnvelope env(vector<Keyframe>(), exponential != 0);
+
+	string error;
+
+	if (!GainEnvelope::tryParse(keyframes, format->sampling_rate,
+			exponential != 0, env, error)) {
+
+		return fail(SAMP_ERROR_SPEC, error);
+
+	}
+
+	r.env = &env;
+
+	return dispatch<EnvelopeJob>(r);
+
+}
+
+samp_status samp_stats(const samp_format* format, const void* in,
+		size_t frames, samp_channel_stats* stats) {
+
+	Request r = request(format, in, frames, nullptr);
+
+	r.stats = stats;
+
+	if (!validBuffer(in, frames) || stats == nullptr) {
+
+		return invalid("invalid buffer");
+
+	}
+
+	return dispatch<StatsJob>(r);
+
+}
@@ -0,0 +1,154 @@
+//=================================================================================
+// Name        : samp.h
+// Author      : Kyle du Plessis [DPLKYL002]
+// Date:       : 07/05/2019
+// Description : libsamp C API: the audio operations of the samp program on
+// 				 caller-provided sample buffers, for in-process use
+//=================================================================================
+
+#include <stddef.h>
+
+#ifndef LIBS_SAMP_H
+#define LIBS_SAMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// only the C API is exported (-fvisibility=hidden and the libsamp.map version script)
+#pragma GCC visibility push(default)
+
+/*Conventions:
+
+Samples are interleaved signed 8 or 16 bit PCM, exactly as in a .raw file, and
+sizes are counted in frames (one sample per channel). Every function is
+reentrant and thread-safe: it reads only its arguments, never touches files,
+stdout or global state, and never exits; failures are reported as a
+samp_status, with a description from samp_last_error() (kept per thread).
+
+Operations that keep the clip length write `frames` frames to `out`, which may
+be the input buffer itself. Operations that change the length take the
+capacity of `out` in frames and set *out_frames to the result length; if it
+does not fit they return SAMP_ERROR_BUFFER_TOO_SMALL without writing, so a call
+with capacity 0 queries the length. Per-channel arguments (gains, rms values,
+statistics) are arrays with one entry per channel.*/
+
+typedef enum samp_status {
+
+	SAMP_OK = 0,
+
+	// a null pointer, an invalid range or a clip longer than INT_MAX frames
+	SAMP_ERROR_ARGUMENT = 1,
+
+	// sampling rate <= 0, bit count other than 8 / 16, or channels not 1, 2, 4, 6, 8
+	SAMP_ERROR_FORMAT = 2,
+
+	// invalid filter or keyframe specification
+	SAMP_ERROR_SPEC = 3,
+
+	SAMP_ERROR_BUFFER_TOO_SMALL = 4,
+
+	SAMP_ERROR_OUT_OF_MEMORY = 5,
+
+	SAMP_ERROR_INTERNAL = 6
+
+} samp_status;
+
+typedef struct samp_format {
+
+	int sampling_rate;
+
+	int bit_count;
+
+	int channels;
+
+} samp_format;
+
+// per-channel QA metrics (see -stats)
+typedef struct samp_channel_stats {
+
+	double peak, peak_dbfs, rms, rms_dbfs, dc_offset;
+
+	int min, max;
+
+	long clipped_samples, zero_crossings;
+
+} samp_channel_stats;
+
+// description of the calling thread's last error ("" after a success)
+const char* samp_last_error(void);
+
+// -add: a + b
+samp_status samp_add(const samp_format* format, const void* a, size_t a_frames,
+		const void* b, size_t b_frames, void* out, size_t capacity,
+		size_t* out_frames);
+
+// -radd: a with frames [first, last) of b added to its frames [first, last)
+samp_status samp_ranged_add(const samp_format* format, const void* a,
+		size_t a_frames, const void* b, size_t b_frames, size_t first,
+		size_t last, void* out);
+
+// -cut: remove frames first to last (inclusive)
+samp_status samp_cut(const samp_format* format, const void* in, size_t frames,
+		size_t first, size_t last, void* out, size_t capacity,
+		size_t* out_frames);
+
+// -cat: a followed by b
+samp_status samp_concat(const samp_format* format, const void* a,
+		size_t a_frames, const void* b, size_t b_frames, void* out,
+		size_t capacity, size_t* out_frames);
+
+// -xfade: a followed by b with an equal-power crossfade of `seconds`
+samp_status samp_crossfade(const samp_format* format, const void* a,
+		size_t a_frames, const void* b, size_t b_frames, float seconds,
+		void* out, size_t capacity, size_t* out_frames);
+
+// -rev
+samp_status samp_reverse(const samp_format* format, const void* in,
+		size_t frames, void* out);
+
+// -v: one gain factor per channel
+samp_status samp_volume(const samp_format* format, const void* in,
+		size_t frames, const float* gains, void* out);
+
+// -rms: one rms value per channel
+samp_status samp_rms(const samp_format* format, const void* in, size_t frames,
+		float* rms);
+
+// -norm: scale each channel to the given rms value
+samp_status samp_normalize(const samp_format* format, const void* in,
+		size_t frames, const float* rms, void* out);
+
+// -filter: biquad cascade, e.g. "dc,lp:8000" (see the README)
+samp_status samp_filter(const samp_format* format, const void* in,
+		size_t frames, const char* spec, void* out);
+
+// -compress (linked: one gain for all channels)
+samp_status samp_compress(const samp_format* format, const void* in,
+		size_t frames, float threshold_db, float ratio, float attack_ms,
+		float release_ms, float lookahead_ms, int linked, void* out);
+
+// -limit
+samp_status samp_limit(const samp_format* format, const void* in,
+		size_t frames, float threshold_db, float release_ms, float lookahead_ms,
+		int linked, void* out);
+
+// -fade: fade in / out over the first / last seconds (exponential: dB ramps)
+samp_status samp_fade(const samp_format* format, const void* in, size_t frames,
+		float fade_in, float fade_out, int exponential, void* out);
+
+// -envelope: keyframed gain, e.g. "0:0,2:1,30:1,32:0.25"
+samp_status samp_envelope(const samp_format* format, const void* in,
+		size_t frames, const char* keyframes, int exponential, void* out);
+
+// -stats: one samp_channel_stats per channel
+samp_status samp_stats(const samp_format* format, const void* in,
+		size_t frames, samp_channel_stats* stats);
+
+#pragma GCC visibility pop
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif